@@ -8,321 +8,3383 @@
 #include <linux/slab.h>
 #include <linux/mm.h>
 #include <linux/jiffies.h>
-#include <linux/timer.h> 
+#include <linux/workqueue.h>
+#include <linux/moduleparam.h>
+#include <linux/math64.h>
+#include <linux/spinlock.h>
+#include <linux/seqlock.h>
+#include <linux/rcupdate.h>
+#include <linux/rculist.h>
+#include <linux/pid.h>
+#include <linux/tracepoint.h>
+#include <linux/fs.h>
+#include <linux/fs_context.h>
+#include <linux/version.h>
+#include <linux/perf_event.h>
+#include <linux/llist.h>
+#include <linux/cpu.h>
+#include <linux/cpumask.h>
+#include <linux/percpu.h>
+#include <linux/hash.h>
+#include <linux/atomic.h>
+#include <linux/sched/clock.h>
+#include <linux/rbtree.h>
+#include <linux/vmalloc.h>
+#include <linux/poll.h>
+#include <linux/wait.h>
+#include <linux/log2.h>
+#include <linux/cred.h>
+#include <linux/uidgid.h>
+#include <linux/cgroup.h>
+#include <linux/parser.h>
+#include <linux/debugfs.h>
+#include <net/genetlink.h>
 #include <linux/list.h>
 #include <linux/mutex.h>
+#include <linux/hashtable.h>
+#include <linux/ktime.h>
+
+#include "process_risk_uapi.h"
+#include "process_risk_score.h"
+
+#define CREATE_TRACE_POINTS
+#include "process_risk_trace.h"
 
 MODULE_LICENSE("GPL");
 MODULE_AUTHOR("Alexandre A., Augusto M., Felipe K., Hugo T., Matheus A., Vinicius B., Vinicius G.");
 MODULE_DESCRIPTION("Módulo que monitora continuamente processos e avalia risco");
 
-#define PROC_DIRNAME "process_risk"
-#define MONITOR_INTERVAL_JIFFIES (5 * HZ) // intervalo de monitoramento (5 segundos)
+#define PROC_DIRNAME "process_risk"
+#define PROCESS_RISK_FS_MAGIC 0x70726973  // "pris"
+#define PROCESS_RISK_PID_INO_OFFSET 16    // números de inode dos <pid> = pid + offset
+#define PROCESS_RISK_HISTORY_INO_OFFSET (PROCESS_RISK_PID_INO_OFFSET + PID_MAX_LIMIT)  // history/<pid>
+#define PROCESS_RISK_READDIR_BATCH 32     // PIDs copiados por bucket a cada passo do readdir
+#define MONITOR_INTERVAL_MS_DEFAULT 5000   // intervalo padrão de monitoramento (5 segundos)
+#define MONITOR_INTERVAL_MS_MIN     100
+#define MONITOR_INTERVAL_MS_MAX     3600000
+#define PROCESS_HASH_BITS 12              // 4096 buckets para o índice por PID
+#define SPARE_INFO_SLACK 64               // folga de entradas pré-alocadas por varredura
+#define SPARE_INFO_MAX   4096             // limite do estoque de entradas pré-alocadas
+#define MAX_TRACKED_DEFAULT 65536         // limite padrão de processos monitorados
+#define EVICT_BATCH 256                   // despejos por vez ao reduzir o limite em execução
+#define SCAN_HIST_BUCKETS 24              // faixas log2 em us; a última acumula acima de ~4s
+#define MIN_SAMPLE_NS (100 * NSEC_PER_MSEC)  // intervalo mínimo entre coletas de uma entrada
+#define SHARD_MIN_ENTRIES 1024            // entradas mínimas por shard antes de usar mais CPUs
+#define SYSCALL_SLOT_BITS 8               // 256 slots por CPU para a contagem de syscalls
+#define SYSCALL_SAMPLE_PERIOD 1024        // mede o custo do probe a cada N syscalls por CPU
+#define TOP_K_DEFAULT 20                  // processos listados em /proc/process_risk/top
+#define TOP_K_MAX     1024
+#define SNAPSHOT_ENTRIES_DEFAULT 8192     // registros em /proc/process_risk/snapshot
+#define SNAPSHOT_ENTRIES_MAX     (1 << 20)
+#define EVENTS_RING_DEFAULT 256           // eventos por leitor de /proc/process_risk/events
+#define EVENTS_RING_MAX     65536
+#define HISTORY_LEN 8                     // amostras guardadas por processo
+#define HOT_INTERVAL_MS_DEFAULT 500       // período de coleta da faixa rápida
+#define IDLE_FACTOR_DEFAULT     6         // faixa ociosa: interval_ms * fator
+#define IDLE_STREAK_MIN         3         // amostras ociosas seguidas para descer de faixa
+#define CGROUP_HASH_BITS 10               // 1024 buckets para o índice de cgroups
+#define FILTER_TEXT_LEN  256              // tamanho máximo dos parâmetros de filtro em texto
+
+// amostra guardada no histórico de cada processo (métricas já normalizadas para 5s)
+struct process_risk_sample {
+    u32 time_ms;                        // ktime em ms, truncado (usado só para calcular idades)
+    u32 cpu_delta_ms;
+    u32 syscalls_delta;
+    u32 io_delta_kb;
+    u32 mem_rss_mb;
+};
+
+// faixas de amostragem: cada entrada é coletada no período da sua faixa, reavaliada a
+// cada coleta
+enum process_risk_tier {
+    TIER_HOT,                           // risco alto ou métricas mudando rápido
+    TIER_NORMAL,                        // interval_ms
+    TIER_IDLE,                          // sem atividade há várias amostras
+    NR_TIERS,
+};
+
+static const char * const tier_names[] = {
+    [TIER_HOT]    = "rápida",
+    [TIER_NORMAL] = "normal",
+    [TIER_IDLE]   = "ociosa",
+};
+
+static const char * const risk_level_names[] = {
+    [RISK_LOW]    = "Baixo",
+    [RISK_MEDIUM] = "Médio",
+    [RISK_HIGH]   = "Alto",
+};
+
+/*
+ * Entrada de um processo monitorado, alocada do kmem_cache process_risk_info
+ * (SLAB_HWCACHE_ALIGN). Os campos estão ordenados por frequência de acesso:
+ * o que a varredura lê e escreve a cada intervalo fica nas duas primeiras linhas
+ * de cache; nome, nó RCU e contadores de controle ficam no final.
+ */
+struct process_risk_info {
+    // --- quente: índice e lista percorridos pela varredura e pelo lookup ---
+    struct hlist_node hnode;            // nó para o índice hash por PID (publicado via RCU)
+    struct list_head list;              // nó para a lista encadeada do kernel
+    struct list_head tier_node;         // posição na lista da faixa (só o worker mexe)
+    pid_t pid;
+    u8 risk;                            // enum process_risk_level
+    u8 score;                           // pontuação que define o risco e a ordem no top
+    bool exited;                        // grupo de threads terminou (marcado pelo tracepoint de saída)
+    bool syscalls_exact;                // syscalls_delta veio da contagem real (raw_syscalls:sys_enter)
+    u8 tier;                            // enum process_risk_tier
+    u8 idle_streak;                     // amostras ociosas seguidas
+    u32 filter_gen;                     // geração dos filtros com que a entrada foi aceita
+    seqlock_t stat_lock;                // versiona nome e métricas para os leitores sem lock
+    u64 start_time_ns;                  // início do processo (distingue PIDs reutilizados)
+    u64 last_sample_ns;                 // instante da última coleta (para normalizar os deltas)
+    u64 next_sample_ns;                 // próxima coleta, conforme a faixa
+
+    // --- quente: contadores cumulativos da coleta anterior (para cálculo de deltas) ---
+    u64 prev_cpu_ns;                    // utime + stime
+    u64 prev_io_bytes;                  // read_bytes + write_bytes
+    u64 prev_faults;                    // min_flt + maj_flt
+    u64 prev_syscalls;                  // valor de syscalls na coleta anterior
+    atomic64_t syscalls;                // syscalls contadas, somadas a partir dos slots por CPU
+
+    // métricas calculadas como deltas, normalizadas para a janela de 5s
+    // independentemente do intervalo real entre as coletas
+    u32 cpu_delta_ms;                   // uso de CPU em millissegundos
+    u32 syscalls_delta;                 // chamadas de sistema contadas no sys_enter quando a contagem
+                                        // está ativa; senão, estimativa com base em page/faults
+                                        // (não é uma contagem exata, mas uma aproximação)
+    u32 io_delta_kb;                    // E/S total em KB no intervalo
+    u32 mem_rss_mb;                     // memória fisica RSS em MB (é um valor instantâneo, não um delta)
+    u32 nr_threads;                     // threads vivas do grupo na última coleta
+
+    // --- histórico: escrito a cada coleta, lido na avaliação e em history/<pid> ---
+    struct risk_averages avg;           // médias e tendência de memória usadas na pontuação
+    u32 prev_rss_kb;
+    u8 history_head;                    // próxima posição de history
+    u8 history_count;
+    struct process_risk_sample history[HISTORY_LEN];
+
+    // --- frio: só usado na criação, no exec, na exibição e na liberação ---
+    u64 last_seen_scan;                 // última varredura em que o processo foi visto
+    struct llist_node retire_node;      // fila de entradas retiradas, consumida pelo worker
+    struct rb_node top_node;            // posição no índice por pontuação (se score > 0)
+    struct list_head evict_node;        // posição na lista de despejo do nível (vazia se alto)
+    uid_t uid;                          // uid real do líder, atualizado a cada coleta
+    u64 cgroup_id;                      // cgroup v2 do líder, atualizado a cada coleta
+    struct cgroup_risk *cg;             // agregado onde as métricas atuais estão somadas
+    char comm[TASK_COMM_LEN];           // nome do processo
+    struct rcu_head rcu;                // liberação adiada até os leitores RCU terminarem
+};
+
+/*
+ * Agregado de um cgroup v2: soma das métricas atuais dos processos monitorados que
+ * pertencem a ele. As somas são mantidas incrementalmente: cada coleta aplica só a
+ * diferença entre as métricas novas e as antigas da entrada, e a saída do processo
+ * subtrai o que ele tinha somado, então nunca há um segundo percurso pelos processos.
+ */
+struct cgroup_risk {
+    struct hlist_node hnode;            // índice por id (RCU)
+    struct list_head list;              // lista percorrida pelo worker
+    u64 cgroup_id;
+    atomic_t nr_procs;
+    atomic64_t cpu_ms;
+    atomic64_t syscalls;
+    atomic64_t io_kb;
+    atomic64_t rss_mb;
+    u8 score;                           // recalculados pelo worker a cada tick
+    u8 risk;
+    struct rcu_head rcu;
+};
+
+// cópia consistente dos campos exibidos de uma entrada, obtida sem lock
+struct process_risk_view {
+    pid_t pid;
+    u64 start_time_ns;
+    char comm[TASK_COMM_LEN];
+    u32 cpu_delta_ms;
+    u32 syscalls_delta;
+    u32 io_delta_kb;
+    u32 mem_rss_mb;
+    u32 nr_threads;
+    enum process_risk_level risk;
+    u8 score;
+    bool syscalls_exact;
+    uid_t uid;
+    u64 cgroup_id;
+};
+
+// instância de processo exibida por um arquivo <pid>, fixada no lookup: o PID sozinho
+// pode ser reutilizado por outro processo enquanto o arquivo continua aberto
+struct process_risk_pid_key {
+    pid_t pid;
+    u64 start_time_ns;
+};
+
+// métricas cumulativas de um grupo de threads em um instante
+struct group_sample {
+    u64 cpu_ns;                         // utime + stime
+    u64 io_bytes;                       // read_bytes + write_bytes
+    u64 faults;                         // min_flt + maj_flt
+    u32 nr_threads;
+};
+
+// variáveis globais para o ponto de montagem em /proc, worker, lista de processos e mutex.
+// process_info_list pertence ao worker (protegida pelo mutex); o índice hash, a lista
+// de pendentes e o estoque de entradas livres são compartilhados com os tracepoints,
+// que rodam com preempção desabilitada, e por isso ficam sob o spinlock.
+// os leitores de /proc/process_risk não usam nenhum dos dois: percorrem o índice sob RCU
+// e copiam as métricas com o seqlock de cada entrada.
+static struct proc_dir_entry *parent_dir;
+static struct workqueue_struct *monitor_wq;
+static struct delayed_work monitor_work;
+static LIST_HEAD(process_info_list); 
+static DEFINE_HASHTABLE(process_info_hash, PROCESS_HASH_BITS);
+static DEFINE_MUTEX(process_info_mutex);
+static DEFINE_SPINLOCK(process_info_lock);
+static struct kmem_cache *process_info_cachep;
+
+// snapshot binário da tabela inteira (cabeçalho + registros), alocado com vmalloc_user e
+// mapeado somente leitura pelos consumidores. só o worker escreve, sob process_info_mutex.
+static void *snapshot_buf;
+static size_t snapshot_size;
+
+// índice das entradas com pontuação > 0, ordenado por pontuação decrescente e PID.
+// só é alterado quando a pontuação de uma entrada muda, ou quando ela é retirada.
+static struct rb_root top_index = RB_ROOT;
+static DEFINE_SPINLOCK(top_lock);
+
+// listas de despejo dos níveis baixo e médio, também sob top_lock: cada entrada vai para o
+// fim da lista do seu nível quando a pontuação muda, então o início de evict_lru[RISK_LOW]
+// é o processo menos arriscado há mais tempo sem mudança. entradas de risco alto nunca
+// são despejadas.
+static struct list_head evict_lru[RISK_HIGH] = {
+    LIST_HEAD_INIT(evict_lru[RISK_LOW]),
+    LIST_HEAD_INIT(evict_lru[RISK_MEDIUM]),
+};
+
+// agregados por cgroup: inseridos pelos shards sob cgroup_risk_lock, lidos sob RCU e
+// removidos pelo worker quando ficam vazios (entre as varreduras dos shards)
+static DEFINE_HASHTABLE(cgroup_risk_hash, CGROUP_HASH_BITS);
+static LIST_HEAD(cgroup_risk_list);
+static DEFINE_SPINLOCK(cgroup_risk_lock);
+static unsigned long cgroup_count;
+static atomic_long_t cgroup_alloc_failures;
+
+// processos criados pelos tracepoints, ainda não incorporados pelo worker
+static LIST_HEAD(pending_info_list);
+
+// entradas retiradas do índice (saída, PID reutilizado ou processo não encontrado),
+// esperando o worker removê-las da lista e liberá-las
+static LLIST_HEAD(retired_info_list);
+
+// listas de entradas por faixa. cada coleta devolve a entrada ao fim da lista da sua
+// faixa com o período da faixa, então cada lista fica em ordem de vencimento e um tick só
+// toca as entradas vencidas. só o worker mexe nelas, sob process_info_mutex.
+static struct list_head tier_lists[NR_TIERS] = {
+    LIST_HEAD_INIT(tier_lists[TIER_HOT]),
+    LIST_HEAD_INIT(tier_lists[TIER_NORMAL]),
+    LIST_HEAD_INIT(tier_lists[TIER_IDLE]),
+};
+
+// entradas vencidas retiradas das listas no tick atual; a capacidade cresce com a tabela
+static struct process_risk_info **scan_batch;
+static unsigned long scan_batch_cap;
+
+// atualização das métricas do lote dividida em shards, cada um executado em uma CPU
+// diferente pela workqueue por-CPU shard_wq
+struct scan_shard {
+    struct work_struct work;
+    unsigned long first;                // posições do lote
+    unsigned long last;                 // exclusivo
+    u64 now_ns;
+    u64 generation;
+};
+
+static struct workqueue_struct *shard_wq;
+static struct scan_shard *scan_shards;  // nr_cpu_ids posições
+static unsigned int scan_last_shards;
+
+// entradas pré-alocadas (GFP_KERNEL) consumidas pelos tracepoints e pela reconciliação
+static LIST_HEAD(spare_info_list);
+static unsigned long spare_count;
+
+// força uma varredura completa de for_each_process na próxima execução do worker
+// (carga do módulo ou eventos de fork que não puderam ser registrados)
+static bool reconcile_pending = true;
+
+// contadores de eventos dos tracepoints (protegidos pelo spinlock)
+static unsigned long events_fork;
+static unsigned long events_exec;
+static unsigned long events_exit;
+static unsigned long events_missed;
+static unsigned long forks_since_scan;
+static u64 events_probe_ns;             // tempo gasto nos probes de fork/exec/exit
+
+// contadores do limite de entradas (protegidos pelo spinlock)
+static unsigned long entries_evicted;   // entradas retiradas para dar lugar a processos novos
+static unsigned long entries_rejected;  // processos não monitorados por falta de vaga
+static unsigned long cap_rejected;      // recusas desde a última reconciliação
+static unsigned long cap_retry_at;      // jiffies da próxima reconciliação para as recusas
+static unsigned long alloc_failures;    // estoque vazio (tracepoints) ou alocação falhou
+
+// contagem de syscalls: cada CPU acumula em slots próprios indexados pelo tgid, sem tocar
+// linhas de cache compartilhadas; o worker soma os slots nas entradas antes de cada varredura
+struct syscall_slot {
+    pid_t tgid;
+    u32 count;
+};
+
+struct syscall_cpu_stats {
+    struct syscall_slot slots[1 << SYSCALL_SLOT_BITS];
+    u64 calls;                          // syscalls vistas nesta CPU
+    u64 sampled_ns;                     // tempo gasto no probe nas chamadas amostradas
+    u64 samples;
+    u64 evictions;                      // slots trocados de tgid (soma antecipada na entrada)
+    u64 dropped;                        // contagens de processos não monitorados
+};
+
+static DEFINE_PER_CPU_ALIGNED(struct syscall_cpu_stats, syscall_cpu);
+static bool count_syscalls;             // modo pedido pelo parâmetro
+static bool syscall_probe_active;       // probe de sys_enter registrado
+
+// estatísticas de custo das varreduras, exibidas em /proc/process_risk/stats
+static u64 scan_generation;
+static u64 scan_last_ns;
+static u64 scan_max_ns;
+static u64 scan_total_ns;
+static unsigned long scan_last_tasks;
+static unsigned long scan_deferred_tasks;
+static unsigned long scan_reconciles;
+static unsigned long tracked_count;
+static unsigned long tier_count[NR_TIERS];  // entradas em cada lista de faixa
+static u64 snapshot_next_ns;            // próxima publicação do snapshot (a cada interval_ms)
+static unsigned long scan_budget_limited;  // ticks em que o orçamento adiou coletas
+
+// leitores de /proc/process_risk/events e contadores do fluxo de eventos (sob event_lock)
+static LIST_HEAD(event_readers);
+static DEFINE_SPINLOCK(event_lock);
+static unsigned int event_reader_count;
+static unsigned long events_emitted;
+static unsigned long events_dropped;
+
+// cache misses de hardware da última varredura (-1 se o contador não estiver disponível)
+static s64 scan_cache_misses = -1;
+
+// fases da varredura medidas em histogramas log2, exibidos em debugfs
+enum scan_phase {
+    SCAN_PHASE_WALK,                    // reconciliação com for_each_process e limite de entradas
+    SCAN_PHASE_MATCH,                   // soma dos slots de syscalls por CPU nas entradas
+    SCAN_PHASE_REFRESH,                 // coleta e pontuação nos shards
+    SCAN_PHASE_CGROUPS,
+    SCAN_PHASE_PUBLISH,                 // snapshot lido pelos arquivos de /proc/process_risk
+    SCAN_PHASE_CLEANUP,                 // incorporação das novas e liberação das retiradas
+    SCAN_PHASE_TOTAL,
+    NR_SCAN_PHASES,
+};
+
+static const char * const scan_phase_names[] = {
+    [SCAN_PHASE_WALK]    = "percurso",
+    [SCAN_PHASE_MATCH]   = "syscalls",
+    [SCAN_PHASE_REFRESH] = "coleta",
+    [SCAN_PHASE_CGROUPS] = "cgroups",
+    [SCAN_PHASE_PUBLISH] = "snapshot",
+    [SCAN_PHASE_CLEANUP] = "limpeza",
+    [SCAN_PHASE_TOTAL]   = "total",
+};
+
+// faixa 0: < 1us; faixa n: [2^(n-1), 2^n) us. escritos só pelo worker, sob process_info_mutex
+struct scan_hist {
+    unsigned long buckets[SCAN_HIST_BUCKETS];
+    u64 max_ns;
+};
+
+static struct scan_hist scan_hist[NR_SCAN_PHASES];
+
+// entradas criadas e liberadas por varredura (última e total)
+static unsigned long scan_last_created;
+static unsigned long scan_last_retired;
+static unsigned long scan_total_created;
+static unsigned long scan_total_retired;
+static unsigned long scan_total_seen;
+
+static struct dentry *process_risk_debugfs;
+
+// intervalo entre varreduras, ajustável em /sys/module/process_risk/parameters/interval_ms
+static unsigned int interval_ms = MONITOR_INTERVAL_MS_DEFAULT;
+
+// período da faixa rápida e multiplicador da faixa ociosa
+static unsigned int hot_interval_ms = HOT_INTERVAL_MS_DEFAULT;
+module_param(hot_interval_ms, uint, 0644);
+MODULE_PARM_DESC(hot_interval_ms, "Período de coleta dos processos na faixa rápida em ms (padrão 500)");
+
+static unsigned int idle_factor = IDLE_FACTOR_DEFAULT;
+module_param(idle_factor, uint, 0644);
+MODULE_PARM_DESC(idle_factor, "Período da faixa ociosa em múltiplos de interval_ms (padrão 6)");
+
+// limite de coletas por segundo somando todas as faixas (0 = sem limite)
+static unsigned int scan_budget;
+module_param(scan_budget, uint, 0644);
+MODULE_PARM_DESC(scan_budget, "Máximo de coletas por segundo (0 = sem limite)");
+
+// limite de entradas monitoradas; acima dele os processos novos despejam os menos arriscados
+static unsigned int max_tracked = MAX_TRACKED_DEFAULT;
+module_param(max_tracked, uint, 0644);
+MODULE_PARM_DESC(max_tracked, "Máximo de processos monitorados (padrão 65536, 0 = sem limite)");
+
+// o worker acorda no período da faixa rápida e coleta só as entradas vencidas
+static unsigned int monitor_tick_ms(void) {
+    return clamp_val(READ_ONCE(hot_interval_ms), MONITOR_INTERVAL_MS_MIN, READ_ONCE(interval_ms));
+}
+
+static u64 tier_period_ns(enum process_risk_tier tier) {
+    switch (tier) {
+    case TIER_HOT:
+        return (u64)monitor_tick_ms() * NSEC_PER_MSEC;
+    case TIER_IDLE:
+        return (u64)READ_ONCE(interval_ms) * max(READ_ONCE(idle_factor), 1U) * NSEC_PER_MSEC;
+    default:
+        return (u64)READ_ONCE(interval_ms) * NSEC_PER_MSEC;
+    }
+}
+
+static int interval_ms_set(const char *val, const struct kernel_param *kp) {
+    unsigned int new_ms;
+    int ret;
+
+    ret = kstrtouint(val, 0, &new_ms);
+    if (ret)
+        return ret;
+    if (new_ms < MONITOR_INTERVAL_MS_MIN || new_ms > MONITOR_INTERVAL_MS_MAX)
+        return -EINVAL;
+
+    WRITE_ONCE(interval_ms, new_ms);
+
+    // reagenda a próxima varredura com o novo intervalo (o worker só existe entre init e exit)
+    mutex_lock(&process_info_mutex);
+    if (monitor_wq)
+        mod_delayed_work(monitor_wq, &monitor_work, msecs_to_jiffies(monitor_tick_ms()));
+    mutex_unlock(&process_info_mutex);
+    return 0;
+}
+
+static const struct kernel_param_ops interval_ms_ops = {
+    .set = interval_ms_set,
+    .get = param_get_uint,
+};
+module_param_cb(interval_ms, &interval_ms_ops, &interval_ms, 0644);
+MODULE_PARM_DESC(interval_ms, "Intervalo entre varreduras em ms (padrão 5000)");
+
+// número máximo de CPUs usadas para atualizar as métricas em paralelo (0 = todas as online)
+static unsigned int scan_cpus;
+module_param(scan_cpus, uint, 0644);
+MODULE_PARM_DESC(scan_cpus, "Máximo de CPUs usadas por varredura (0 = todas as CPUs online)");
+
+// quantos processos /proc/process_risk/top lista
+static unsigned int top_k = TOP_K_DEFAULT;
+module_param(top_k, uint, 0644);
+MODULE_PARM_DESC(top_k, "Processos listados em /proc/process_risk/top (padrão 20, máximo 1024)");
+
+// capacidade do snapshot binário; fixa durante a vida do módulo porque o buffer é mapeado
+static unsigned int snapshot_entries = SNAPSHOT_ENTRIES_DEFAULT;
+module_param(snapshot_entries, uint, 0444);
+MODULE_PARM_DESC(snapshot_entries, "Registros em /proc/process_risk/snapshot (padrão 8192)");
+
+// tamanho do anel de eventos de cada leitor, arredondado para potência de 2
+static unsigned int events_ring = EVENTS_RING_DEFAULT;
+module_param(events_ring, uint, 0644);
+MODULE_PARM_DESC(events_ring, "Eventos por leitor de /proc/process_risk/events (padrão 256)");
+
+// inclui em /proc/process_risk/<pid> os contadores de cada thread viva do processo
+static bool show_threads;
+module_param(show_threads, bool, 0644);
+MODULE_PARM_DESC(show_threads, "Mostra o detalhamento por thread em /proc/process_risk/<pid> (padrão 0)");
+
+// ordem do índice top: pontuação maior primeiro; empate pelo menor PID
+static bool top_index_less(struct rb_node *a, const struct rb_node *b) {
+    struct process_risk_info *ia = rb_entry(a, struct process_risk_info, top_node);
+    struct process_risk_info *ib = rb_entry(b, struct process_risk_info, top_node);
+
+    if (ia->score != ib->score)
+        return ia->score > ib->score;
+    return ia->pid < ib->pid;
+}
+
+// reposiciona a entrada no índice top e nas listas de despejo com a nova pontuação. a
+// pontuação só muda sob top_lock para que as comparações feitas por inserções concorrentes
+// fiquem consistentes. entradas já retiradas (exited) nunca voltam ao índice, pois
+// process_info_retire as remove sob o mesmo lock.
+static void top_index_update(struct process_risk_info *info, u8 score) {
+    enum process_risk_level level = risk_level(score);
+    unsigned long flags;
+
+    spin_lock_irqsave(&top_lock, flags);
+    if (!RB_EMPTY_NODE(&info->top_node)) {
+        rb_erase(&info->top_node, &top_index);
+        RB_CLEAR_NODE(&info->top_node);
+    }
+    list_del_init(&info->evict_node);
+    info->score = score;
+    if (!READ_ONCE(info->exited)) {
+        if (score)
+            rb_add(&info->top_node, &top_index, top_index_less);
+        if (level != RISK_HIGH)
+            list_add_tail(&info->evict_node, &evict_lru[level]);
+    }
+    spin_unlock_irqrestore(&top_lock, flags);
+}
+
+static void top_index_remove(struct process_risk_info *info) {
+    unsigned long flags;
+
+    spin_lock_irqsave(&top_lock, flags);
+    if (!RB_EMPTY_NODE(&info->top_node)) {
+        rb_erase(&info->top_node, &top_index);
+        RB_CLEAR_NODE(&info->top_node);
+    }
+    list_del_init(&info->evict_node);
+    spin_unlock_irqrestore(&top_lock, flags);
+}
+
+// entrada menos arriscada e há mais tempo sem mudar de pontuação, ou NULL se só restam
+// entradas de risco alto. o chamador a retira sob process_info_lock.
+static struct process_risk_info *evict_candidate(void) {
+    struct process_risk_info *info = NULL;
+    unsigned long flags;
+    int level;
+
+    spin_lock_irqsave(&top_lock, flags);
+    for (level = RISK_LOW; level < RISK_HIGH && !info; level++)
+        info = list_first_entry_or_null(&evict_lru[level], struct process_risk_info, evict_node);
+    spin_unlock_irqrestore(&top_lock, flags);
+    return info;
+}
+
+// a pontuação usa as médias móveis em vez do último delta: um pico isolado (ex: uma
+// compilação) não basta para marcar o processo, e a memória pontua tanto pelo valor
+// atual quanto pelo crescimento sustentado, o que pega vazamentos lentos.
+static void evaluate_and_set_risk(struct process_risk_info *info) {
+    int score = risk_averages_score(&info->avg, info->mem_rss_mb);
+
+    // mantém o índice top incrementalmente: só reposiciona quando a pontuação muda
+    if (score != info->score)
+        top_index_update(info, score);
+
+    info->risk = risk_level(score);
+}
+
+// métricas de uma entrada que entram na soma do seu cgroup
+struct cgroup_contrib {
+    u32 cpu_ms;
+    u32 syscalls;
+    u32 io_kb;
+    u32 rss_mb;
+};
+
+static void cgroup_contrib_get(const struct process_risk_info *info, struct cgroup_contrib *c) {
+    c->cpu_ms = info->cpu_delta_ms;
+    c->syscalls = info->syscalls_delta;
+    c->io_kb = info->io_delta_kb;
+    c->rss_mb = info->mem_rss_mb;
+}
+
+static void cgroup_risk_add(struct cgroup_risk *cg, const struct cgroup_contrib *add,
+                            const struct cgroup_contrib *sub) {
+    atomic64_add((s64)add->cpu_ms - sub->cpu_ms, &cg->cpu_ms);
+    atomic64_add((s64)add->syscalls - sub->syscalls, &cg->syscalls);
+    atomic64_add((s64)add->io_kb - sub->io_kb, &cg->io_kb);
+    atomic64_add((s64)add->rss_mb - sub->rss_mb, &cg->rss_mb);
+}
+
+static struct cgroup_risk *cgroup_risk_lookup(u64 cgroup_id) {
+    struct cgroup_risk *cg;
+
+    hash_for_each_possible_rcu(cgroup_risk_hash, cg, hnode, cgroup_id) {
+        if (cg->cgroup_id == cgroup_id)
+            return cg;
+    }
+    return NULL;
+}
+
+// procura ou cria o agregado; chamada pelos shards dentro da seção RCU, por isso não dorme
+static struct cgroup_risk *cgroup_risk_get(u64 cgroup_id) {
+    struct cgroup_risk *cg, *new;
+
+    cg = cgroup_risk_lookup(cgroup_id);
+    if (cg)
+        return cg;
+
+    new = kzalloc(sizeof(*new), GFP_NOWAIT | __GFP_NOWARN);
+    if (!new) {
+        atomic_long_inc(&cgroup_alloc_failures);
+        return NULL;
+    }
+    new->cgroup_id = cgroup_id;
+
+    // outro shard pode ter criado o mesmo agregado enquanto este alocava
+    spin_lock(&cgroup_risk_lock);
+    cg = cgroup_risk_lookup(cgroup_id);
+    if (!cg) {
+        hash_add_rcu(cgroup_risk_hash, &new->hnode, cgroup_id);
+        list_add_tail(&new->list, &cgroup_risk_list);
+        cgroup_count++;
+        cg = new;
+        new = NULL;
+    }
+    spin_unlock(&cgroup_risk_lock);
+
+    kfree(new);
+    return cg;
+}
+
+// retira da soma do cgroup o que a entrada tinha contribuído (chamada com stat_lock)
+static void cgroup_risk_detach(struct process_risk_info *info, const struct cgroup_contrib *old) {
+    static const struct cgroup_contrib zero;
+    struct cgroup_risk *cg = info->cg;
+
+    if (!cg)
+        return;
+    cgroup_risk_add(cg, &zero, old);
+    atomic_dec(&cg->nr_procs);
+    info->cg = NULL;
+}
+
+// aplica ao cgroup a diferença entre as métricas antigas e as atuais da entrada, movendo-a
+// de agregado se o processo mudou de cgroup. chamada pelos shards com stat_lock.
+static void cgroup_risk_account(struct process_risk_info *info, const struct cgroup_contrib *old) {
+    static const struct cgroup_contrib zero;
+    struct cgroup_contrib cur;
+    struct cgroup_risk *cg = info->cg;
+
+    // a saída do processo já tirou a entrada do agregado
+    if (READ_ONCE(info->exited))
+        return;
+
+    cgroup_contrib_get(info, &cur);
+    if (cg && cg->cgroup_id == info->cgroup_id) {
+        cgroup_risk_add(cg, &cur, old);
+        return;
+    }
+
+    cgroup_risk_detach(info, old);
+    cg = cgroup_risk_get(info->cgroup_id);
+    if (!cg)
+        return;
+    atomic_inc(&cg->nr_procs);
+    cgroup_risk_add(cg, &cur, &zero);
+    info->cg = cg;
+}
+
+// pontua cada cgroup pelas somas, com os mesmos limiares dos processos, e descarta os
+// agregados vazios. roda no worker depois dos shards, então nada insere na lista agora.
+static void cgroup_risk_update(void) {
+    struct cgroup_risk *cg, *tmp;
+    int score;
+
+    list_for_each_entry_safe(cg, tmp, &cgroup_risk_list, list) {
+        if (!atomic_read(&cg->nr_procs)) {
+            spin_lock(&cgroup_risk_lock);
+            hash_del_rcu(&cg->hnode);
+            list_del(&cg->list);
+            cgroup_count--;
+            spin_unlock(&cgroup_risk_lock);
+            kfree_rcu(cg, rcu);
+            continue;
+        }
+
+        // sem o termo de crescimento de memória, que só existe por processo
+        score = risk_score(atomic64_read(&cg->cpu_ms), atomic64_read(&cg->syscalls),
+                           atomic64_read(&cg->io_kb), atomic64_read(&cg->rss_mb), 0);
+
+        WRITE_ONCE(cg->score, score);
+        WRITE_ONCE(cg->risk, risk_level(score));
+    }
+}
+
+// busca a entrada de um processo no índice hash (O(1) em média). deve ser chamada com
+// process_info_lock ou dentro de rcu_read_lock. o bucket é escolhido pelo PID; quem chama
+// compara o start_time para distinguir a instância do processo de um PID reutilizado.
+static struct process_risk_info *process_info_lookup(pid_t pid) {
+    struct process_risk_info *info;
+
+    hash_for_each_possible_rcu(process_info_hash, info, hnode, pid,
+                               lockdep_is_held(&process_info_lock)) {
+        if (info->pid == pid)
+            return info;
+    }
+    return NULL;
+}
+
+// busca a entrada da mesma instância do processo da chave (dentro de rcu_read_lock).
+// start_time_ns é fixado antes da entrada ser publicada no índice e não muda depois
+static struct process_risk_info *process_info_lookup_key(const struct process_risk_pid_key *key) {
+    struct process_risk_info *info = process_info_lookup(key->pid);
+
+    return info && info->start_time_ns == key->start_time_ns ? info : NULL;
+}
+
+// copia os campos exibidos; quem chama garante a consistência (stat_lock de escrita
+// ou o laço de releitura de process_info_read)
+static void process_info_copy(const struct process_risk_info *info, struct process_risk_view *view) {
+    view->pid = info->pid;
+    view->start_time_ns = info->start_time_ns;
+    memcpy(view->comm, info->comm, TASK_COMM_LEN);
+    view->cpu_delta_ms = info->cpu_delta_ms;
+    view->syscalls_delta = info->syscalls_delta;
+    view->io_delta_kb = info->io_delta_kb;
+    view->mem_rss_mb = info->mem_rss_mb;
+    view->nr_threads = info->nr_threads;
+    view->risk = info->risk;
+    view->score = info->score;
+    view->syscalls_exact = info->syscalls_exact;
+    view->uid = info->uid;
+    view->cgroup_id = info->cgroup_id;
+}
+
+static void process_info_read(struct process_risk_info *info, struct process_risk_view *view) {
+    unsigned int seq;
+
+    do {
+        seq = read_seqbegin(&info->stat_lock);
+        process_info_copy(info, view);
+    } while (read_seqretry(&info->stat_lock, seq));
+}
+
+// soma as métricas de todas as threads do grupo: os contadores que signal_struct acumula
+// das threads que já terminaram mais os das threads vivas. processos de uma só thread
+// (a maioria) leem apenas o líder; as threads só são percorridas nos multithread, então
+// o custo total fica proporcional ao número de threads, sem um segundo percurso por processo.
+// uma thread que termina passa seus contadores para signal_struct e sai da lista sob
+// stats_lock, então a soma segue o protocolo de thread_group_cputime(): primeiro sem lock,
+// e com o lock se a leitura foi interrompida, para que a thread não seja contada duas vezes.
+// deve ser chamada dentro de rcu_read_lock (ou com a task estável, como no fork).
+static void process_sample_group(struct task_struct *task, struct group_sample *gs) {
+    struct signal_struct *sig = task->signal;
+    struct task_struct *t;
+    unsigned int seq, nextseq = 0;
+    unsigned long flags;
+
+    do {
+        seq = nextseq;
+        flags = read_seqbegin_or_lock_irqsave(&sig->stats_lock, &seq);
+
+        gs->cpu_ns = sig->utime + sig->stime;
+        gs->io_bytes = sig->ioac.read_bytes + sig->ioac.write_bytes;
+        gs->faults = sig->min_flt + sig->maj_flt;
+        gs->nr_threads = get_nr_threads(task);
+
+        if (gs->nr_threads <= 1) {
+            gs->cpu_ns += task->utime + task->stime;
+            gs->io_bytes += task->ioac.read_bytes + task->ioac.write_bytes;
+            gs->faults += task->min_flt + task->maj_flt;
+        } else {
+            for_each_thread(task, t) {
+                gs->cpu_ns += t->utime + t->stime;
+                gs->io_bytes += t->ioac.read_bytes + t->ioac.write_bytes;
+                gs->faults += t->min_flt + t->maj_flt;
+            }
+        }
+        nextseq = 1;    // se a leitura sem lock falhou, a próxima toma o lock
+    } while (need_seqretry(&sig->stats_lock, seq));
+    done_seqretry_irqrestore(&sig->stats_lock, seq, flags);
+}
+
+static u32 process_rss_kb(struct task_struct *task) {
+    return task->mm ? (get_mm_rss(task->mm) * PAGE_SIZE) >> 10 : 0;
+}
+
+// dono do processo (uid real) e cgroup v2, usados nos filtros de consulta
+static void process_sample_owner(struct process_risk_info *info, struct task_struct *task) {
+    rcu_read_lock();
+    info->uid = from_kuid_munged(&init_user_ns, task_uid(task));
+#ifdef CONFIG_CGROUPS
+    info->cgroup_id = cgroup_id(task_dfl_cgroup(task));
+#else
+    info->cgroup_id = 0;
+#endif
+    rcu_read_unlock();
+}
+
+// copia os contadores cumulativos da task para a entrada e zera os deltas
+static void process_info_reset(struct process_risk_info *info, struct task_struct *task, u64 now_ns) {
+    struct group_sample gs;
+
+    process_sample_group(task, &gs);
+
+    info->start_time_ns = task->start_time;
+    info->last_sample_ns = now_ns;
+    strncpy(info->comm, task->comm, TASK_COMM_LEN - 1);
+    info->comm[TASK_COMM_LEN - 1] = '\0';
+    process_sample_owner(info, task);
+
+    info->prev_cpu_ns = gs.cpu_ns;
+    info->prev_io_bytes = gs.io_bytes;
+    info->prev_faults = gs.faults;
+    info->nr_threads = gs.nr_threads;
+    info->prev_syscalls = 0;
+    atomic64_set(&info->syscalls, 0);
+    info->syscalls_exact = false;
+
+    info->cpu_delta_ms = 0;
+    info->syscalls_delta = 0;
+    info->io_delta_kb = 0;
+
+    info->prev_rss_kb = process_rss_kb(task);
+    info->mem_rss_mb = info->prev_rss_kb >> 10;
+
+    // as médias partem de zero, então a primeira amostra pesa só 1/4 (um processo recém
+    // criado não herda o nível do seu primeiro pico)
+    risk_averages_init(&info->avg);
+    info->history_head = 0;
+    info->history_count = 0;
+}
+
+// atualiza os contadores da entrada a partir da task e recalcula os deltas
+static bool process_info_refresh(struct process_risk_info *info, struct task_struct *task, u64 now_ns) {
+    u64 elapsed_ns = now_ns - info->last_sample_ns;
+    struct risk_counters prev, cur;
+    struct risk_deltas d;
+    struct group_sample gs;
+    u64 syscalls;
+
+    // coletas muito próximas (ex: processo criado logo antes da varredura) amplificariam
+    // o delta na normalização; mantém a amostra anterior
+    if (elapsed_ns < MIN_SAMPLE_NS)
+        return false;
+
+    // CPU, E/S e faults somados sobre todas as threads do processo
+    process_sample_group(task, &gs);
+
+    // com a contagem de syscalls ativa usa o valor real; senão, page faults como aproximação
+    syscalls = atomic64_read(&info->syscalls);
+    info->syscalls_exact = READ_ONCE(syscall_probe_active);
+
+    prev = (struct risk_counters) {
+        .cpu_ns   = info->prev_cpu_ns,
+        .io_bytes = info->prev_io_bytes,
+        .events   = info->syscalls_exact ? info->prev_syscalls : info->prev_faults,
+        .rss_kb   = info->prev_rss_kb,
+    };
+    cur = (struct risk_counters) {
+        .cpu_ns   = gs.cpu_ns,
+        .io_bytes = gs.io_bytes,
+        .events   = info->syscalls_exact ? syscalls : gs.faults,
+        .rss_kb   = process_rss_kb(task),
+    };
+    risk_refresh(&d, &info->avg, &prev, &cur, elapsed_ns);
+
+    info->cpu_delta_ms = d.cpu_ms;
+    info->syscalls_delta = d.syscalls;
+    info->io_delta_kb = d.io_kb;
+    info->mem_rss_mb = d.rss_mb;
+    info->nr_threads = gs.nr_threads;
+
+    info->prev_syscalls = syscalls;
+    info->prev_cpu_ns = gs.cpu_ns;
+    info->prev_io_bytes = gs.io_bytes;
+    info->prev_faults = gs.faults;
+    info->prev_rss_kb = cur.rss_kb;
+    info->last_sample_ns = now_ns;
+    process_sample_owner(info, task);
+
+    info->history[info->history_head] = (struct process_risk_sample) {
+        .time_ms        = (u32)div_u64(now_ns, NSEC_PER_MSEC),
+        .cpu_delta_ms   = info->cpu_delta_ms,
+        .syscalls_delta = info->syscalls_delta,
+        .io_delta_kb    = info->io_delta_kb,
+        .mem_rss_mb     = info->mem_rss_mb,
+    };
+    info->history_head = (info->history_head + 1) % HISTORY_LEN;
+    if (info->history_count < HISTORY_LEN)
+        info->history_count++;
+    return true;
+}
+
+// completa o estoque de entradas livres antes de incorporar os eventos. a alocação é feita
+// aqui, com GFP_KERNEL; os tracepoints só consomem entradas já alocadas. o alvo acompanha
+// a taxa de forks do último intervalo para absorver rajadas de processos curtos.
+static void spare_info_refill(void) {
+    unsigned long target, have;
+
+    spin_lock(&process_info_lock);
+    target = min_t(unsigned long, SPARE_INFO_SLACK + forks_since_scan, SPARE_INFO_MAX);
+    forks_since_scan = 0;
+    have = spare_count;
+    spin_unlock(&process_info_lock);
+
+    while (have < target) {
+        struct process_risk_info *info = kmem_cache_alloc(process_info_cachep, GFP_KERNEL);
+        if (!info)
+            break;
+        spin_lock(&process_info_lock);
+        list_add(&info->list, &spare_info_list);
+        spare_count++;
+        spin_unlock(&process_info_lock);
+        have++;
+    }
+}
+
+// retira uma entrada do estoque. os tracepoints só usam o estoque; a reconciliação, que
+// roda no worker, ainda pode tentar uma alocação sem espera quando ele acaba.
+// deve ser chamada com process_info_lock.
+static struct process_risk_info *spare_info_get(bool may_alloc) {
+    struct process_risk_info *info;
+
+    info = list_first_entry_or_null(&spare_info_list, struct process_risk_info, list);
+    if (info) {
+        list_del(&info->list);
+        spare_count--;
+        return info;
+    }
+    if (!may_alloc)
+        return NULL;
+    return kmem_cache_alloc(process_info_cachep, GFP_NOWAIT | __GFP_NOWARN);
+}
+
+static void process_info_free_rcu(struct rcu_head *head) {
+    kmem_cache_free(process_info_cachep, container_of(head, struct process_risk_info, rcu));
+}
+
+static void spare_info_free_all(void) {
+    struct process_risk_info *info, *temp;
+
+    list_for_each_entry_safe(info, temp, &spare_info_list, list) {
+        list_del(&info->list);
+        kmem_cache_free(process_info_cachep, info);
+    }
+    spare_count = 0;
+}
+
+/*
+ * Filtros de monitoramento, aplicados antes de qualquer alocação: tarefas rejeitadas
+ * nunca ganham entrada. A configuração é imutável e publicada por RCU; cada parâmetro
+ * alterado gera uma cópia nova, força uma reconciliação (para acrescentar o que passou
+ * a ser aceito) e incrementa filter_generation, o que faz a varredura reavaliar e
+ * retirar as entradas já existentes que passaram a ser rejeitadas.
+ */
+enum process_filter_reason {
+    FILTER_PASS,
+    FILTER_KTHREAD,
+    FILTER_UID,
+    FILTER_CGROUP,
+    FILTER_COMM,
+    NR_FILTER_REASONS,
+};
+
+struct process_filter {
+    bool skip_kthreads;
+    bool has_uid_range;
+    uid_t uid_min;
+    uid_t uid_max;
+    struct cgroup *cgroup;                  // só processos desta subárvore (referência própria)
+    char cgroup_path[FILTER_TEXT_LEN];
+    char skip_comm[FILTER_TEXT_LEN];        // padrões com * e ?, separados por vírgula
+};
+
+static struct process_filter __rcu *process_filter;
+static DEFINE_MUTEX(filter_mutex);
+static u32 filter_generation;
+static unsigned long filter_skipped[NR_FILTER_REASONS];  // sob process_info_lock
+
+static bool filter_comm_match(const char *patterns, const char *comm) {
+    char pat[FILTER_TEXT_LEN];
+    const char *p = patterns;
+    size_t len;
+
+    while (*p) {
+        len = strcspn(p, ",");
+        if (len) {
+            memcpy(pat, p, len);
+            pat[len] = '\0';
+            if (match_wildcard(pat, comm))
+                return true;
+        }
+        p += len;
+        if (*p == ',')
+            p++;
+    }
+    return false;
+}
+
+// motivo pelo qual a tarefa não deve ser monitorada, ou FILTER_PASS
+static enum process_filter_reason process_filter_check(struct task_struct *task) {
+    enum process_filter_reason reason = FILTER_PASS;
+    const struct process_filter *f;
+    uid_t uid;
+
+    rcu_read_lock();
+    f = rcu_dereference(process_filter);
+    if (!f)
+        goto out;
+
+    if (f->skip_kthreads && (task->flags & PF_KTHREAD)) {
+        reason = FILTER_KTHREAD;
+        goto out;
+    }
+    if (f->has_uid_range) {
+        uid = from_kuid_munged(&init_user_ns, task_uid(task));
+        if (uid < f->uid_min || uid > f->uid_max) {
+            reason = FILTER_UID;
+            goto out;
+        }
+    }
+#ifdef CONFIG_CGROUPS
+    if (f->cgroup && !cgroup_is_descendant(task_dfl_cgroup(task), f->cgroup)) {
+        reason = FILTER_CGROUP;
+        goto out;
+    }
+#endif
+    if (f->skip_comm[0] && filter_comm_match(f->skip_comm, task->comm))
+        reason = FILTER_COMM;
+out:
+    rcu_read_unlock();
+    return reason;
+}
+
+// troca a configuração dos filtros: apply altera uma cópia da atual
+static int process_filter_update(int (*apply)(struct process_filter *f, const char *val), const char *val) {
+    struct process_filter *old, *new;
+    struct cgroup *old_cgroup = NULL;
+    int ret;
+
+    new = kzalloc(sizeof(*new), GFP_KERNEL);
+    if (!new)
+        return -ENOMEM;
+
+    mutex_lock(&filter_mutex);
+    old = rcu_dereference_protected(process_filter, lockdep_is_held(&filter_mutex));
+    if (old) {
+        *new = *old;
+        if (new->cgroup)
+            cgroup_get(new->cgroup);
+    }
+
+    ret = apply(new, val);
+    if (ret) {
+        mutex_unlock(&filter_mutex);
+        if (new->cgroup)
+            cgroup_put(new->cgroup);
+        kfree(new);
+        return ret;
+    }
+
+    rcu_assign_pointer(process_filter, new);
+    mutex_unlock(&filter_mutex);
+
+    spin_lock(&process_info_lock);
+    filter_generation++;
+    reconcile_pending = true;
+    spin_unlock(&process_info_lock);
+
+    if (old) {
+        synchronize_rcu();
+        old_cgroup = old->cgroup;
+        kfree(old);
+    }
+    if (old_cgroup)
+        cgroup_put(old_cgroup);
+    return 0;
+}
+
+static void process_filter_free(void) {
+    struct process_filter *f = rcu_dereference_protected(process_filter, 1);
+
+    RCU_INIT_POINTER(process_filter, NULL);
+    if (!f)
+        return;
+    if (f->cgroup)
+        cgroup_put(f->cgroup);
+    kfree(f);
+}
+
+static int filter_apply_kthreads(struct process_filter *f, const char *val) {
+    return kstrtobool(val, &f->skip_kthreads);
+}
+
+// "min-max", ou vazio para aceitar qualquer uid
+static int filter_apply_uid_range(struct process_filter *f, const char *val) {
+    unsigned int min, max;
+
+    if (!*val || *val == '\n') {
+        f->has_uid_range = false;
+        return 0;
+    }
+    if (sscanf(val, "%u-%u", &min, &max) != 2 || min > max)
+        return -EINVAL;
+    f->has_uid_range = true;
+    f->uid_min = min;
+    f->uid_max = max;
+    return 0;
+}
+
+// caminho do cgroup v2 relativo à raiz (ex: /kubepods.slice), ou vazio para todos
+static int filter_apply_cgroup(struct process_filter *f, const char *val) {
+    struct cgroup *cgrp = NULL;
+    char path[FILTER_TEXT_LEN];
+
+    if (strscpy(path, val, sizeof(path)) < 0)
+        return -EINVAL;
+    strim(path);
+
+    if (path[0]) {
+#ifdef CONFIG_CGROUPS
+        cgrp = cgroup_get_from_path(path);
+        if (IS_ERR(cgrp))
+            return PTR_ERR(cgrp);
+#else
+        return -EOPNOTSUPP;
+#endif
+    }
+
+    if (f->cgroup)
+        cgroup_put(f->cgroup);
+    f->cgroup = cgrp;
+    strscpy(f->cgroup_path, path, sizeof(f->cgroup_path));
+    return 0;
+}
+
+static int filter_apply_comm(struct process_filter *f, const char *val) {
+    if (strscpy(f->skip_comm, val, sizeof(f->skip_comm)) < 0)
+        return -EINVAL;
+    strim(f->skip_comm);
+    return 0;
+}
+
+static int skip_kthreads_set(const char *val, const struct kernel_param *kp) {
+    return process_filter_update(filter_apply_kthreads, val);
+}
+
+static int uid_range_set(const char *val, const struct kernel_param *kp) {
+    return process_filter_update(filter_apply_uid_range, val);
+}
+
+static int cgroup_subtree_set(const char *val, const struct kernel_param *kp) {
+    return process_filter_update(filter_apply_cgroup, val);
+}
+
+static int skip_comm_set(const char *val, const struct kernel_param *kp) {
+    return process_filter_update(filter_apply_comm, val);
+}
+
+// leitura dos parâmetros: formata o campo correspondente da configuração atual
+static int filter_param_get(char *buf, const struct kernel_param *kp) {
+    const struct process_filter *f;
+    int len = 0;
+
+    rcu_read_lock();
+    f = rcu_dereference(process_filter);
+    if (!strcmp(kp->name, "skip_kthreads"))
+        len = sysfs_emit(buf, "%c\n", f && f->skip_kthreads ? 'Y' : 'N');
+    else if (!strcmp(kp->name, "uid_range"))
+        len = f && f->has_uid_range ? sysfs_emit(buf, "%u-%u\n", f->uid_min, f->uid_max) : sysfs_emit(buf, "\n");
+    else if (!strcmp(kp->name, "cgroup_subtree"))
+        len = sysfs_emit(buf, "%s\n", f ? f->cgroup_path : "");
+    else if (!strcmp(kp->name, "skip_comm"))
+        len = sysfs_emit(buf, "%s\n", f ? f->skip_comm : "");
+    rcu_read_unlock();
+    return len;
+}
+
+static const struct kernel_param_ops skip_kthreads_ops = { .set = skip_kthreads_set, .get = filter_param_get };
+static const struct kernel_param_ops uid_range_ops = { .set = uid_range_set, .get = filter_param_get };
+static const struct kernel_param_ops cgroup_subtree_ops = { .set = cgroup_subtree_set, .get = filter_param_get };
+static const struct kernel_param_ops skip_comm_ops = { .set = skip_comm_set, .get = filter_param_get };
+
+module_param_cb(skip_kthreads, &skip_kthreads_ops, NULL, 0644);
+MODULE_PARM_DESC(skip_kthreads, "Não monitora threads do kernel (padrão 0)");
+module_param_cb(uid_range, &uid_range_ops, NULL, 0644);
+MODULE_PARM_DESC(uid_range, "Monitora só processos com uid no intervalo min-max (vazio = todos)");
+module_param_cb(cgroup_subtree, &cgroup_subtree_ops, NULL, 0644);
+MODULE_PARM_DESC(cgroup_subtree, "Monitora só processos desta subárvore de cgroup v2 (vazio = todos)");
+module_param_cb(skip_comm, &skip_comm_ops, NULL, 0644);
+MODULE_PARM_DESC(skip_comm, "Padrões de nome ignorados, com * e ?, separados por vírgula");
+
+// retira a entrada do índice (o <pid> some do diretório); o worker libera a memória depois
+// de um grace period, pois leitores RCU ainda podem estar com ela.
+// deve ser chamada com process_info_lock.
+static void process_info_retire(struct process_risk_info *info) {
+    struct cgroup_contrib cur;
+
+    hash_del_rcu(&info->hnode);
+    WRITE_ONCE(info->exited, true);
+    top_index_remove(info);
+
+    write_seqlock(&info->stat_lock);
+    cgroup_contrib_get(info, &cur);
+    cgroup_risk_detach(info, &cur);
+    write_sequnlock(&info->stat_lock);
+
+    llist_add(&info->retire_node, &retired_info_list);
+    tracked_count--;
+}
+
+// cria a entrada de um processo e a publica no índice e na lista de pendentes.
+// com o limite max_tracked atingido, um processo vindo dos tracepoints (probe) despeja a
+// entrada menos arriscada; na reconciliação o processo simplesmente fica de fora.
+// deve ser chamada com process_info_lock; devolve false se não houver memória.
+static bool process_info_track(struct task_struct *task, u64 now_ns, bool probe) {
+    enum process_filter_reason reason = process_filter_check(task);
+    struct process_risk_info *info, *victim = NULL;
+    unsigned int max = READ_ONCE(max_tracked);
+
+    // tarefas filtradas são descartadas antes de qualquer alocação
+    if (reason != FILTER_PASS) {
+        filter_skipped[reason]++;
+        return true;
+    }
+
+    if (max && tracked_count >= max) {
+        victim = probe ? evict_candidate() : NULL;
+        if (!victim) {
+            entries_rejected++;
+            cap_rejected++;     // procurado de novo quando houver vaga (cap_retry_due)
+            return true;
+        }
+    }
+
+    info = spare_info_get(!probe);
+    if (!info) {
+        alloc_failures++;
+        return false;
+    }
+
+    if (victim) {
+        process_info_retire(victim);
+        entries_evicted++;
+    }
+
+    info->pid = task->tgid;
+    info->exited = false;
+    info->tier = TIER_NORMAL;
+    info->idle_streak = 0;
+    info->filter_gen = filter_generation;
+    info->next_sample_ns = 0;  // coletada no próximo tick
+    INIT_LIST_HEAD(&info->tier_node);  // entra na lista da faixa quando o worker a incorpora
+    info->cg = NULL;           // entra no agregado do cgroup na primeira coleta
+    info->last_seen_scan = 0;
+    RB_CLEAR_NODE(&info->top_node);
+    INIT_LIST_HEAD(&info->evict_node);
+    seqlock_init(&info->stat_lock);
+    process_info_reset(info, task, now_ns);
+    top_index_update(info, 0);  // entra no fim da lista de despejo do nível baixo
+    evaluate_and_set_risk(info);
+
+    // hash_add_rcu publica a entrada já inicializada para os leitores
+    hash_add_rcu(process_info_hash, &info->hnode, info->pid);
+    list_add_tail(&info->list, &pending_info_list);
+    tracked_count++;
+    return true;
+}
+
+// tracepoint sched_process_fork: registra cada novo processo (líder de grupo) na hora
+static void probe_sched_process_fork(void *data, struct task_struct *parent, struct task_struct *child) {
+    u64 t0;
+
+    if (!thread_group_leader(child))
+        return;     // novas threads são contabilizadas no processo
+
+    t0 = local_clock();
+    spin_lock(&process_info_lock);
+    events_fork++;
+    forks_since_scan++;
+    if (!process_info_track(child, ktime_get_ns(), true)) {
+        events_missed++;
+        reconcile_pending = true;
+    }
+    events_probe_ns += local_clock() - t0;
+    spin_unlock(&process_info_lock);
+}
+
+// tracepoint sched_process_exec: o processo trocou de imagem, atualiza o nome
+static void probe_sched_process_exec(void *data, struct task_struct *p, pid_t old_pid,
+                                     struct linux_binprm *bprm) {
+    u64 t0 = local_clock();
+    enum process_filter_reason reason = process_filter_check(p);
+    struct process_risk_info *info;
+
+    // o novo nome pode mudar o resultado do filtro de comm: uma entrada existente
+    // passa a ser rejeitada, ou um processo antes ignorado passa a ser monitorado
+    spin_lock(&process_info_lock);
+    events_exec++;
+    info = process_info_lookup(p->tgid);
+    if (info && info->start_time_ns == p->group_leader->start_time) {
+        if (reason != FILTER_PASS) {
+            filter_skipped[reason]++;
+            process_info_retire(info);
+        } else {
+            write_seqlock(&info->stat_lock);
+            strscpy(info->comm, p->comm, TASK_COMM_LEN);
+            write_sequnlock(&info->stat_lock);
+        }
+    } else if (!info && reason == FILTER_PASS) {
+        if (!process_info_track(p->group_leader, ktime_get_ns(), true)) {
+            events_missed++;
+            reconcile_pending = true;
+        }
+    }
+    events_probe_ns += local_clock() - t0;
+    spin_unlock(&process_info_lock);
+}
+
+// tracepoint sched_process_exit: dispara por thread; a entrada é retirada quando a
+// última thread do grupo sai (signal->live já foi decrementado neste ponto). a partir do
+// 6.16 o tracepoint também recebe group_dead, que diz a mesma coisa
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 16, 0)
+static void probe_sched_process_exit(void *data, struct task_struct *p, bool group_dead) {
+#else
+static void probe_sched_process_exit(void *data, struct task_struct *p) {
+    bool group_dead = !atomic_read(&p->signal->live);
+#endif
+    struct process_risk_info *info;
+    u64 t0;
+
+    if (!group_dead)
+        return;
+
+    t0 = local_clock();
+    spin_lock(&process_info_lock);
+    events_exit++;
+    info = process_info_lookup(p->tgid);
+    if (info && info->start_time_ns == p->group_leader->start_time)
+        process_info_retire(info);
+    events_probe_ns += local_clock() - t0;
+    spin_unlock(&process_info_lock);
+}
+
+// soma a contagem do slot na entrada do processo. chamada com interrupções desabilitadas
+// na CPU dona do slot e dentro de rcu_read_lock
+static void syscall_slot_flush(struct syscall_cpu_stats *sc, struct syscall_slot *slot) {
+    struct process_risk_info *info = process_info_lookup(slot->tgid);
+
+    if (info)
+        atomic64_add(slot->count, &info->syscalls);
+    else
+        sc->dropped += slot->count;
+    slot->count = 0;
+}
+
+// tracepoint raw_syscalls:sys_enter. o caminho comum só incrementa um slot da própria CPU;
+// o acesso à entrada (compartilhada) acontece apenas quando outro tgid ocupa o slot.
+// as interrupções ficam desabilitadas para não correr com a soma feita por IPI.
+static void probe_sys_enter(void *data, struct pt_regs *regs, long id) {
+    struct syscall_cpu_stats *sc;
+    struct syscall_slot *slot;
+    pid_t tgid = current->tgid;
+    unsigned long flags;
+    bool sample;
+    u64 t0 = 0;
+
+    local_irq_save(flags);
+    sc = this_cpu_ptr(&syscall_cpu);
+    sample = !(sc->calls++ & (SYSCALL_SAMPLE_PERIOD - 1));
+    if (sample)
+        t0 = local_clock();
+
+    slot = &sc->slots[hash_32(tgid, SYSCALL_SLOT_BITS)];
+    if (likely(slot->tgid == tgid)) {
+        slot->count++;
+    } else {
+        if (slot->count) {
+            rcu_read_lock();
+            syscall_slot_flush(sc, slot);
+            rcu_read_unlock();
+            sc->evictions++;
+        }
+        slot->tgid = tgid;
+        slot->count = 1;
+    }
+
+    if (sample) {
+        sc->sampled_ns += local_clock() - t0;
+        sc->samples++;
+    }
+    local_irq_restore(flags);
+}
+
+// executada em cada CPU (on_each_cpu) pelo worker: soma os slots locais nas entradas
+static void syscall_slots_flush_cpu(void *unused) {
+    struct syscall_cpu_stats *sc = this_cpu_ptr(&syscall_cpu);
+    int i;
+
+    rcu_read_lock();
+    for (i = 0; i < ARRAY_SIZE(sc->slots); i++) {
+        if (sc->slots[i].count)
+            syscall_slot_flush(sc, &sc->slots[i]);
+    }
+    rcu_read_unlock();
+}
+
+struct process_risk_tracepoint {
+    const char *name;
+    void *probe;
+    struct tracepoint *tp;
+};
+
+static struct process_risk_tracepoint process_risk_tracepoints[] = {
+    { .name = "sched_process_fork", .probe = probe_sched_process_fork },
+    { .name = "sched_process_exec", .probe = probe_sched_process_exec },
+    { .name = "sched_process_exit", .probe = probe_sched_process_exit },
+};
+
+// registrado só quando a contagem de syscalls está ativa
+static struct process_risk_tracepoint sys_enter_tracepoint = {
+    .name = "sys_enter", .probe = probe_sys_enter,
+};
+
+// os tracepoints do escalonador não são exportados para módulos; localiza pelo nome
+static void lookup_tracepoint(struct tracepoint *tp, void *priv) {
+    int i;
+
+    for (i = 0; i < ARRAY_SIZE(process_risk_tracepoints); i++) {
+        if (!strcmp(tp->name, process_risk_tracepoints[i].name))
+            process_risk_tracepoints[i].tp = tp;
+    }
+    if (!strcmp(tp->name, sys_enter_tracepoint.name))
+        sys_enter_tracepoint.tp = tp;
+}
+
+static void unregister_tracepoints(void) {
+    int i;
+
+    for (i = 0; i < ARRAY_SIZE(process_risk_tracepoints); i++) {
+        if (process_risk_tracepoints[i].tp)
+            tracepoint_probe_unregister(process_risk_tracepoints[i].tp,
+                                        process_risk_tracepoints[i].probe, NULL);
+    }
+    tracepoint_synchronize_unregister();
+}
+
+static int register_tracepoints(void) {
+    int i, ret;
+
+    for_each_kernel_tracepoint(lookup_tracepoint, NULL);
+
+    for (i = 0; i < ARRAY_SIZE(process_risk_tracepoints); i++) {
+        struct tracepoint *tp = process_risk_tracepoints[i].tp;
+
+        if (!tp) {
+            pr_err("Tracepoint %s não encontrado\n", process_risk_tracepoints[i].name);
+            ret = -ENOENT;
+            goto err;
+        }
+        ret = tracepoint_probe_register(tp, process_risk_tracepoints[i].probe, NULL);
+        if (ret) {
+            pr_err("Falha ao registrar o tracepoint %s (%d)\n", process_risk_tracepoints[i].name, ret);
+            process_risk_tracepoints[i].tp = NULL;
+            goto err;
+        }
+    }
+    return 0;
+
+err:
+    unregister_tracepoints();
+    return ret;
+}
+
+// liga ou desliga o probe de sys_enter conforme count_syscalls. chamada com
+// process_info_mutex, na carga do módulo ou pela escrita do parâmetro.
+static int syscall_probe_update(void) {
+    int ret;
+
+    if (count_syscalls == syscall_probe_active)
+        return 0;
+
+    if (!sys_enter_tracepoint.tp) {
+        pr_err("Tracepoint %s não encontrado\n", sys_enter_tracepoint.name);
+        return -ENOENT;
+    }
+
+    if (count_syscalls) {
+        ret = tracepoint_probe_register(sys_enter_tracepoint.tp, sys_enter_tracepoint.probe, NULL);
+        if (ret)
+            return ret;
+    } else {
+        tracepoint_probe_unregister(sys_enter_tracepoint.tp, sys_enter_tracepoint.probe, NULL);
+        tracepoint_synchronize_unregister();
+    }
+    WRITE_ONCE(syscall_probe_active, count_syscalls);
+    return 0;
+}
+
+static int count_syscalls_set(const char *val, const struct kernel_param *kp) {
+    bool enable;
+    int ret;
+
+    ret = kstrtobool(val, &enable);
+    if (ret)
+        return ret;
+
+    mutex_lock(&process_info_mutex);
+    count_syscalls = enable;
+    ret = 0;
+    if (monitor_wq) {   // antes do init o valor só é guardado
+        ret = syscall_probe_update();
+        if (ret)
+            count_syscalls = syscall_probe_active;
+    }
+    mutex_unlock(&process_info_mutex);
+    return ret;
+}
+
+static const struct kernel_param_ops count_syscalls_ops = {
+    .set = count_syscalls_set,
+    .get = param_get_bool,
+};
+module_param_cb(count_syscalls, &count_syscalls_ops, &count_syscalls, 0644);
+MODULE_PARM_DESC(count_syscalls, "Conta syscalls reais por processo via raw_syscalls:sys_enter (padrão 0)");
+
+// processos recusados pelo limite não disparam nenhum evento quando a tabela volta a ter
+// vaga, então uma reconciliação os procura de novo, no máximo uma vez por intervalo
+// normal para que uma tabela no limite com muitas saídas não percorra todas as tarefas a
+// cada tick. deve ser chamada com process_info_lock.
+static bool cap_retry_due(void) {
+    unsigned int max = READ_ONCE(max_tracked);
+
+    if (!cap_rejected || (max && tracked_count >= max) || time_before(jiffies, cap_retry_at))
+        return false;
+    cap_rejected = 0;
+    cap_retry_at = jiffies + msecs_to_jiffies(READ_ONCE(interval_ms));
+    return true;
+}
+
+// varredura completa de for_each_process: usada na carga do módulo, quando algum fork
+// não pôde ser registrado e quando processos recusados pelo limite podem caber de novo.
+// corrige entradas de PIDs reutilizados e cria as que faltam.
+static unsigned long process_info_reconcile(u64 now_ns, unsigned long *deferred) {
+    struct task_struct *task;
+    struct process_risk_info *info;
+    unsigned long tasks_seen = 0;
+
+    rcu_read_lock();
+    for_each_process(task) {
+        tasks_seen++;
+        if (task->flags & PF_EXITING)
+            continue;
+
+        spin_lock(&process_info_lock);
+        info = process_info_lookup(task->pid);
+        if (info && info->start_time_ns == task->start_time) {
+            spin_unlock(&process_info_lock);
+            continue;
+        }
+        if (info)
+            process_info_retire(info);   // PID reutilizado: a saída anterior não foi vista
+        if (!process_info_track(task, now_ns, false)) {
+            (*deferred)++;
+            reconcile_pending = true;
+        }
+        spin_unlock(&process_info_lock);
+    }
+    rcu_read_unlock();
+
+    scan_reconciles++;
+    return tasks_seen;
+}
+
+// aplica uma redução de max_tracked feita em execução, despejando as entradas menos
+// arriscadas em lotes para não segurar o spinlock por muito tempo
+static void process_info_enforce_cap(void) {
+    struct process_risk_info *victim;
+    unsigned int max = READ_ONCE(max_tracked);
+    unsigned int batch;
+    bool more = max;
+
+    while (more) {
+        spin_lock(&process_info_lock);
+        for (batch = 0; batch < EVICT_BATCH && tracked_count > max; batch++) {
+            victim = evict_candidate();
+            if (!victim)
+                break;
+            process_info_retire(victim);
+            entries_evicted++;
+        }
+        more = batch == EVICT_BATCH && tracked_count > max;
+        spin_unlock(&process_info_lock);
+        cond_resched();
+    }
+}
+
+// função de callback para leitura do arquivo /proc/process_risk/stats
+static int proc_stats_show(struct seq_file *m, void *v) {
+    const struct process_risk_snapshot_header *snap = snapshot_buf;
+    u64 calls = 0, sampled_ns = 0, samples = 0, evictions = 0, dropped = 0;
+    u64 scans, avg_ns = 0, probe_ns, syscall_avg_ns = 0;
+    int cpu;
+
+    mutex_lock(&process_info_mutex);
+    scans = scan_generation;
+    if (scans)
+        avg_ns = div64_u64(scan_total_ns, scans);
+    probe_ns = READ_ONCE(events_probe_ns);
+
+    if (syscall_probe_active) {
+        for_each_possible_cpu(cpu) {
+            struct syscall_cpu_stats *sc = per_cpu_ptr(&syscall_cpu, cpu);
+
+            calls += READ_ONCE(sc->calls);
+            sampled_ns += READ_ONCE(sc->sampled_ns);
+            samples += READ_ONCE(sc->samples);
+            evictions += READ_ONCE(sc->evictions);
+            dropped += READ_ONCE(sc->dropped);
+        }
+        if (samples)
+            syscall_avg_ns = div64_u64(sampled_ns, samples);
+    }
+
+    seq_printf(m,
+        "Varreduras: %llu\n"
+        "Processos monitorados: %lu\n"
+        "Intervalo (ms): %u\n"
+        "Período da faixa rápida (ms): %u\n"
+        "Processos por faixa (%s/%s/%s): %lu/%lu/%lu\n"
+        "Orçamento de coletas (/s): %u\n"
+        "Ticks limitados pelo orçamento: %lu\n"
+        "CPUs na última varredura: %u\n"
+        "Tarefas na última varredura: %lu\n"
+        "Tarefas adiadas na última varredura: %lu\n"
+        "Varreduras completas (reconciliação): %lu\n"
+        "Eventos fork/exec/exit: %lu/%lu/%lu\n"
+        "Eventos perdidos: %lu\n"
+        "Limite de processos monitorados: %u\n"
+        "Entradas despejadas/recusadas pelo limite: %lu/%lu\n"
+        "Falhas de alocação de entradas: %lu\n"
+        "Tarefas ignoradas pelos filtros (kthread/uid/cgroup/comm): %lu/%lu/%lu/%lu\n"
+        "Duração da última varredura (us): %llu\n"
+        "Duração média da varredura (us): %llu\n"
+        "Duração máxima da varredura (us): %llu\n"
+        "Tempo total nas varreduras (us): %llu\n"
+        "Tempo total nos probes fork/exec/exit (us): %llu\n"
+        "Custo total do monitor (us, varreduras + probes): %llu\n"
+        "Tamanho da entrada (bytes): %u\n"
+        "Entradas alocadas (monitoradas + reserva): %lu\n"
+        "Memória das entradas (KB): %lu\n"
+        "Registros no snapshot: %u de %u (%u sem espaço)\n"
+        "Cgroups monitorados: %lu\n"
+        "Falhas de alocação de cgroups: %ld\n"
+        "Leitores de eventos: %u\n"
+        "Eventos de risco emitidos/perdidos: %lu/%lu\n",
+        scans,
+        tracked_count,
+        READ_ONCE(interval_ms),
+        monitor_tick_ms(),
+        tier_names[TIER_HOT], tier_names[TIER_NORMAL], tier_names[TIER_IDLE],
+        tier_count[TIER_HOT], tier_count[TIER_NORMAL], tier_count[TIER_IDLE],
+        READ_ONCE(scan_budget),
+        scan_budget_limited,
+        scan_last_shards,
+        scan_last_tasks,
+        scan_deferred_tasks,
+        scan_reconciles,
+        events_fork,
+        events_exec,
+        events_exit,
+        events_missed,
+        READ_ONCE(max_tracked),
+        READ_ONCE(entries_evicted),
+        READ_ONCE(entries_rejected),
+        READ_ONCE(alloc_failures),
+        READ_ONCE(filter_skipped[FILTER_KTHREAD]),
+        READ_ONCE(filter_skipped[FILTER_UID]),
+        READ_ONCE(filter_skipped[FILTER_CGROUP]),
+        READ_ONCE(filter_skipped[FILTER_COMM]),
+        div_u64(scan_last_ns, NSEC_PER_USEC),
+        div_u64(avg_ns, NSEC_PER_USEC),
+        div_u64(scan_max_ns, NSEC_PER_USEC),
+        div_u64(scan_total_ns, NSEC_PER_USEC),
+        div_u64(probe_ns, NSEC_PER_USEC),
+        div_u64(scan_total_ns + probe_ns + calls * syscall_avg_ns, NSEC_PER_USEC),
+        kmem_cache_size(process_info_cachep),
+        tracked_count + spare_count,
+        ((tracked_count + spare_count) * kmem_cache_size(process_info_cachep)) >> 10,
+        snap->count,
+        snap->capacity,
+        snap->dropped,
+        cgroup_count,
+        atomic_long_read(&cgroup_alloc_failures),
+        READ_ONCE(event_reader_count),
+        READ_ONCE(events_emitted),
+        READ_ONCE(events_dropped)
+    );
+
+    if (syscall_probe_active) {
+        seq_printf(m,
+            "Contagem de syscalls: ativa\n"
+            "Syscalls contadas: %llu\n"
+            "Custo médio do probe por syscall (ns): %llu\n"
+            "Tempo estimado no probe de sys_enter (us): %llu\n"
+            "Trocas de slot: %llu\n"
+            "Syscalls de processos não monitorados: %llu\n",
+            calls,
+            syscall_avg_ns,
+            div_u64(calls * syscall_avg_ns, NSEC_PER_USEC),
+            evictions,
+            dropped);
+    } else {
+        seq_puts(m, "Contagem de syscalls: inativa (usando page faults como aproximação)\n");
+    }
+
+    if (scan_cache_misses >= 0) {
+        seq_printf(m, "Cache misses na última varredura (thread do worker): %lld\n", scan_cache_misses);
+        if (scan_last_tasks)
+            seq_printf(m, "Cache misses por processo: %llu\n",
+                       div_u64(scan_cache_misses, scan_last_tasks));
+    } else {
+        seq_puts(m, "Cache misses na última varredura: indisponível\n");
+    }
+
+    mutex_unlock(&process_info_mutex);
+    return 0;
+}
+
+// detalhamento por thread (valores acumulados desde o início de cada thread), calculado
+// na leitura: o custo de percorrer as threads fica com quem pediu, não com a varredura
+static void proc_pid_show_threads(struct seq_file *m, struct process_risk_view *snap) {
+    struct task_struct *task, *t;
+
+    rcu_read_lock();
+    task = pid_task(find_pid_ns(snap->pid, &init_pid_ns), PIDTYPE_PID);
+    if (task && task->start_time == snap->start_time_ns) {
+        seq_puts(m, "Threads (acumulado): TID Nome CPU(ms) E/S(KB) Faults\n");
+        for_each_thread(task, t) {
+            seq_printf(m, "  %d %s %llu %llu %lu\n",
+                       t->pid,
+                       t->comm,
+                       div_u64(t->utime + t->stime, NSEC_PER_MSEC),
+                       (t->ioac.read_bytes + t->ioac.write_bytes) >> 10,
+                       t->min_flt + t->maj_flt);
+        }
+    }
+    rcu_read_unlock();
+}
+
+// função de callback para leitura do arquivo /proc/process_risk/<pid>.
+// o arquivo guarda o PID e o início do processo; a entrada é buscada no índice a cada
+// leitura, então um processo que terminou (ou cujo PID foi reutilizado) devolve -ESRCH
+static int proc_pid_show(struct seq_file *m, void *v) {
+    const struct process_risk_pid_key *key = m->private;
+    struct process_risk_info *info;
+    struct process_risk_view snap;
+
+    // leitura sem lock: nem o worker nem os tracepoints esperam por leitores
+    rcu_read_lock();
+    info = process_info_lookup_key(key);
+    if (info)
+        process_info_read(info, &snap);
+    rcu_read_unlock();
+
+    if (!info) {
+        return -ESRCH;  // o processo não é mais monitorado
+    }
+
+    // exibe as informações do processo e o risco atribuido formatadas no arquivo em /proc/process_risk/<pid>
+    seq_printf(m,
+        "PID: %d\n"
+        "Nome: %s\n"
+        "Uso de CPU (delta ms/5s): %u\n"
+        "Chamadas de Sistema (delta %s/5s): %u\n"
+        "E/S Total (delta KB/5s): %u\n"
+        "Memória (MB): %u\n"
+        "Threads: %u\n"
+        "Risco: %s\n",
+        snap.pid,
+        snap.comm,
+        snap.cpu_delta_ms,
+        snap.syscalls_exact ? "contado" : "aprox",
+        snap.syscalls_delta,
+        snap.io_delta_kb,
+        snap.mem_rss_mb,
+        snap.nr_threads,
+        risk_level_names[snap.risk]
+    );
+
+    if (READ_ONCE(show_threads))
+        proc_pid_show_threads(m, &snap);
+
+    seq_puts(m, "----------------------------------------------------------------\n");
+    return 0;
+}
+
+// cópia consistente do histórico de uma entrada, da amostra mais antiga à mais recente
+struct process_risk_history {
+    pid_t pid;
+    char comm[TASK_COMM_LEN];
+    unsigned int count;
+    struct process_risk_sample samples[HISTORY_LEN];
+    unsigned long cpu_avg;
+    unsigned long syscalls_avg;
+    unsigned long io_avg;
+    s64 mem_trend_kb_min;
+    u8 score;
+    enum process_risk_level risk;
+};
+
+static void process_info_read_history(struct process_risk_info *info, struct process_risk_history *h) {
+    unsigned int seq, i, first;
+
+    do {
+        seq = read_seqbegin(&info->stat_lock);
+        h->pid = info->pid;
+        memcpy(h->comm, info->comm, TASK_COMM_LEN);
+        h->count = info->history_count;
+        first = (info->history_head + HISTORY_LEN - h->count) % HISTORY_LEN;
+        for (i = 0; i < h->count; i++)
+            h->samples[i] = info->history[(first + i) % HISTORY_LEN];
+        h->cpu_avg = ewma_metric_read(&info->avg.cpu);
+        h->syscalls_avg = ewma_metric_read(&info->avg.syscalls);
+        h->io_avg = ewma_metric_read(&info->avg.io);
+        h->mem_trend_kb_min = (info->avg.mem_trend >> 8) * (60 / (RISK_WINDOW_NS / NSEC_PER_SEC));
+        h->score = info->score;
+        h->risk = info->risk;
+    } while (read_seqretry(&info->stat_lock, seq));
+}
+
+// função de callback para leitura de /proc/process_risk/history/<pid>: as médias usadas
+// na pontuação e as últimas amostras do processo
+static int proc_history_show(struct seq_file *m, void *v) {
+    const struct process_risk_pid_key *key = m->private;
+    struct process_risk_info *info;
+    struct process_risk_history *h;
+    u32 now_ms = (u32)div_u64(ktime_get_ns(), NSEC_PER_MSEC);
+    unsigned int i;
+
+    h = kmalloc(sizeof(*h), GFP_KERNEL);
+    if (!h)
+        return -ENOMEM;
+
+    rcu_read_lock();
+    info = process_info_lookup_key(key);
+    if (info)
+        process_info_read_history(info, h);
+    rcu_read_unlock();
+
+    if (!info) {
+        kfree(h);
+        return -ESRCH;
+    }
+
+    seq_printf(m,
+        "PID: %d\n"
+        "Nome: %s\n"
+        "Média de CPU (ms/5s): %lu\n"
+        "Média de Chamadas de Sistema (/5s): %lu\n"
+        "Média de E/S (KB/5s): %lu\n"
+        "Tendência de Memória (KB/min): %lld\n"
+        "Pontuação: %u\n"
+        "Risco: %s\n"
+        "\n%-10s %10s %10s %10s %10s\n",
+        h->pid,
+        h->comm,
+        h->cpu_avg,
+        h->syscalls_avg,
+        h->io_avg,
+        h->mem_trend_kb_min,
+        h->score,
+        risk_level_names[h->risk],
+        "Idade(ms)", "CPU(ms)", "Syscalls", "E/S(KB)", "Mem(MB)");
+
+    for (i = 0; i < h->count; i++) {
+        const struct process_risk_sample *sm = &h->samples[i];
+
+        seq_printf(m, "%-10u %10u %10u %10u %10u\n",
+                   now_ms - sm->time_ms,
+                   sm->cpu_delta_ms,
+                   sm->syscalls_delta,
+                   sm->io_delta_kb,
+                   sm->mem_rss_mb);
+    }
+
+    kfree(h);
+    return 0;
+}
+
+static int proc_pid_open(struct inode *inode, struct file *file) {
+    return single_open(file, proc_pid_show, inode->i_private);
+}
+
+static int proc_history_open(struct inode *inode, struct file *file) {
+    return single_open(file, proc_history_show, inode->i_private);
+}
+
+static int proc_stats_open(struct inode *inode, struct file *file) {
+    return single_open(file, proc_stats_show, NULL);
+}
+
+static const struct file_operations history_file_ops = {
+    .owner   = THIS_MODULE,
+    .open    = proc_history_open,
+    .read    = seq_read,
+    .llseek  = seq_lseek,
+    .release = single_release,
+};
+
+static const struct file_operations pid_file_ops = {
+    .owner   = THIS_MODULE,
+    .open    = proc_pid_open,
+    .read    = seq_read,
+    .llseek  = seq_lseek,
+    .release = single_release,
+};
+
+static const struct file_operations stats_file_ops = {
+    .owner   = THIS_MODULE,
+    .open    = proc_stats_open,
+    .read    = seq_read,
+    .llseek  = seq_lseek,
+    .release = single_release,
+};
+
+// debugfs/process_risk/latency: um histograma log2 por fase da varredura
+static int debugfs_latency_show(struct seq_file *m, void *v) {
+    unsigned int phase, b, last;
+
+    mutex_lock(&process_info_mutex);
+    for (phase = 0; phase < NR_SCAN_PHASES; phase++) {
+        const struct scan_hist *hist = &scan_hist[phase];
+
+        seq_printf(m, "%s (máximo %llu us):\n", scan_phase_names[phase],
+                   div_u64(hist->max_ns, NSEC_PER_USEC));
+
+        // omite as faixas vazias depois da última ocupada
+        for (last = SCAN_HIST_BUCKETS; last > 0 && !hist->buckets[last - 1]; last--)
+            ;
+        for (b = 0; b < last; b++) {
+            if (b == 0)
+                seq_printf(m, "  [0, 1) us: %lu\n", hist->buckets[b]);
+            else if (b == SCAN_HIST_BUCKETS - 1)
+                seq_printf(m, "  [%lu, ...) us: %lu\n", 1UL << (b - 1), hist->buckets[b]);
+            else
+                seq_printf(m, "  [%lu, %lu) us: %lu\n", 1UL << (b - 1), 1UL << b, hist->buckets[b]);
+        }
+    }
+    mutex_unlock(&process_info_mutex);
+    return 0;
+}
+
+// debugfs/process_risk/scans: tarefas vistas, entradas criadas e liberadas
+static int debugfs_scans_show(struct seq_file *m, void *v) {
+    mutex_lock(&process_info_mutex);
+    seq_printf(m,
+        "Varreduras: %llu\n"
+        "Tarefas vistas (última/total): %lu/%lu\n"
+        "Entradas criadas (última/total): %lu/%lu\n"
+        "Entradas liberadas (última/total): %lu/%lu\n",
+        scan_generation,
+        scan_last_tasks, scan_total_seen,
+        scan_last_created, scan_total_created,
+        scan_last_retired, scan_total_retired);
+    mutex_unlock(&process_info_mutex);
+    return 0;
+}
+
+static int debugfs_latency_open(struct inode *inode, struct file *file) {
+    return single_open(file, debugfs_latency_show, NULL);
+}
+
+static int debugfs_scans_open(struct inode *inode, struct file *file) {
+    return single_open(file, debugfs_scans_show, NULL);
+}
+
+static const struct file_operations debugfs_latency_ops = {
+    .owner   = THIS_MODULE,
+    .open    = debugfs_latency_open,
+    .read    = seq_read,
+    .llseek  = seq_lseek,
+    .release = single_release,
+};
+
+static const struct file_operations debugfs_scans_ops = {
+    .owner   = THIS_MODULE,
+    .open    = debugfs_scans_open,
+    .read    = seq_read,
+    .llseek  = seq_lseek,
+    .release = single_release,
+};
+
+// a instrumentação é opcional: falhas do debugfs não impedem a carga do módulo
+static void process_risk_debugfs_init(void) {
+    process_risk_debugfs = debugfs_create_dir("process_risk", NULL);
+    debugfs_create_file("latency", 0444, process_risk_debugfs, NULL, &debugfs_latency_ops);
+    debugfs_create_file("scans", 0444, process_risk_debugfs, NULL, &debugfs_scans_ops);
+}
+
+// função de callback para leitura do arquivo /proc/process_risk/top: os K processos de
+// maior pontuação em uma única leitura. o índice fica travado só enquanto os K ponteiros
+// são copiados; a leitura das métricas e a formatação acontecem depois.
+static int proc_top_show(struct seq_file *m, void *v) {
+    unsigned int k = clamp_val(READ_ONCE(top_k), 1, TOP_K_MAX);
+    struct process_risk_info **entries;
+    struct process_risk_view *views;
+    struct rb_node *node;
+    unsigned long flags;
+    unsigned int n = 0, i;
+
+    views = kvmalloc_array(k, sizeof(*views), GFP_KERNEL);
+    entries = kvmalloc_array(k, sizeof(*entries), GFP_KERNEL);
+    if (!views || !entries) {
+        kvfree(views);
+        kvfree(entries);
+        return -ENOMEM;
+    }
+
+    // sob top_lock só se copiam os ponteiros: ler as métricas espera pelo stat_lock, e a
+    // coleta atualiza o índice (top_lock) com o stat_lock de escrita já tomado. as entradas
+    // só são liberadas depois de um período de graça, então continuam válidas sob RCU.
+    rcu_read_lock();
+    spin_lock_irqsave(&top_lock, flags);
+    for (node = rb_first(&top_index); node && n < k; node = rb_next(node))
+        entries[n++] = rb_entry(node, struct process_risk_info, top_node);
+    spin_unlock_irqrestore(&top_lock, flags);
+    for (i = 0; i < n; i++)
+        process_info_read(entries[i], &views[i]);
+    rcu_read_unlock();
+    kvfree(entries);
+
+    seq_printf(m, "%-8s %-16s %-10s %-6s %10s %10s %10s %10s\n",
+               "PID", "Nome", "Pontuação", "Risco", "CPU(ms)", "Syscalls", "E/S(KB)", "Mem(MB)");
+    for (i = 0; i < n; i++) {
+        seq_printf(m, "%-8d %-16s %-10u %-6s %10u %10u %10u %10u\n",
+                   views[i].pid,
+                   views[i].comm,
+                   views[i].score,
+                   risk_level_names[views[i].risk],
+                   views[i].cpu_delta_ms,
+                   views[i].syscalls_delta,
+                   views[i].io_delta_kb,
+                   views[i].mem_rss_mb);
+    }
+
+    kvfree(views);
+    return 0;
+}
+
+static int proc_top_open(struct inode *inode, struct file *file) {
+    return single_open(file, proc_top_show, NULL);
+}
+
+static const struct file_operations top_file_ops = {
+    .owner   = THIS_MODULE,
+    .open    = proc_top_open,
+    .read    = seq_read,
+    .llseek  = seq_lseek,
+    .release = single_release,
+};
+
+// função de callback para leitura de /proc/process_risk/cgroups: as somas e a pontuação de
+// cada cgroup v2 com processos monitorados, identificado pelo id (o número de inode do
+// diretório do cgroup)
+static int proc_cgroups_show(struct seq_file *m, void *v) {
+    struct cgroup_risk *cg;
+    unsigned int bkt;
+
+    seq_printf(m, "%-20s %-10s %-10s %-6s %10s %10s %10s %10s\n",
+               "Cgroup", "Processos", "Pontuação", "Risco", "CPU(ms)", "Syscalls", "E/S(KB)", "Mem(MB)");
+
+    rcu_read_lock();
+    hash_for_each_rcu(cgroup_risk_hash, bkt, cg, hnode) {
+        int procs = atomic_read(&cg->nr_procs);
+
+        if (!procs)
+            continue;
+        seq_printf(m, "%-20llu %-10d %-10u %-6s %10lld %10lld %10lld %10lld\n",
+                   cg->cgroup_id,
+                   procs,
+                   READ_ONCE(cg->score),
+                   risk_level_names[READ_ONCE(cg->risk)],
+                   atomic64_read(&cg->cpu_ms),
+                   atomic64_read(&cg->syscalls),
+                   atomic64_read(&cg->io_kb),
+                   atomic64_read(&cg->rss_mb));
+    }
+    rcu_read_unlock();
+    return 0;
+}
+
+static int proc_cgroups_open(struct inode *inode, struct file *file) {
+    return single_open(file, proc_cgroups_show, NULL);
+}
+
+static const struct file_operations cgroups_file_ops = {
+    .owner   = THIS_MODULE,
+    .open    = proc_cgroups_open,
+    .read    = seq_read,
+    .llseek  = seq_lseek,
+    .release = single_release,
+};
+
+// /proc/process_risk/snapshot só pode ser mapeado, e somente para leitura: o layout está em
+// process_risk_uapi.h e o leitor usa o seq do cabeçalho para validar cada cópia
+static int snapshot_mmap(struct file *file, struct vm_area_struct *vma) {
+    if (vma->vm_flags & VM_WRITE)
+        return -EPERM;
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 3, 0)
+    vm_flags_clear(vma, VM_MAYWRITE);
+#else
+    vma->vm_flags &= ~VM_MAYWRITE;
+#endif
+    return remap_vmalloc_range(vma, snapshot_buf, vma->vm_pgoff);
+}
+
+static const struct file_operations snapshot_file_ops = {
+    .owner = THIS_MODULE,
+    .mmap  = snapshot_mmap,
+};
+
+// interface generic netlink: consulta de um PID, dump da tabela com filtros aplicados no
+// kernel e alertas multicast de mudança de nível (atributos em process_risk_uapi.h)
+static struct genl_family process_risk_genl_family;
+
+struct process_risk_nl_filter {
+    bool has_uid;
+    uid_t uid;
+    bool has_cgroup;
+    u64 cgroup_id;
+    u8 min_score;
+};
+
+static const struct nla_policy process_risk_nl_policy[PROCESS_RISK_A_MAX + 1] = {
+    [PROCESS_RISK_A_PID]       = { .type = NLA_U32 },
+    [PROCESS_RISK_A_UID]       = { .type = NLA_U32 },
+    [PROCESS_RISK_A_CGROUP]    = { .type = NLA_U64 },
+    [PROCESS_RISK_A_MIN_SCORE] = { .type = NLA_U8 },
+};
+
+static int process_risk_nl_put_view(struct sk_buff *skb, const struct process_risk_view *view) {
+    if (nla_put_u32(skb, PROCESS_RISK_A_PID, view->pid) ||
+        nla_put_string(skb, PROCESS_RISK_A_COMM, view->comm) ||
+        nla_put_u64_64bit(skb, PROCESS_RISK_A_START_TIME, view->start_time_ns, PROCESS_RISK_A_PAD) ||
+        nla_put_u32(skb, PROCESS_RISK_A_CPU_MS, view->cpu_delta_ms) ||
+        nla_put_u32(skb, PROCESS_RISK_A_SYSCALLS, view->syscalls_delta) ||
+        nla_put_u32(skb, PROCESS_RISK_A_IO_KB, view->io_delta_kb) ||
+        nla_put_u32(skb, PROCESS_RISK_A_MEM_MB, view->mem_rss_mb) ||
+        nla_put_u32(skb, PROCESS_RISK_A_THREADS, view->nr_threads) ||
+        nla_put_u8(skb, PROCESS_RISK_A_SCORE, view->score) ||
+        nla_put_u8(skb, PROCESS_RISK_A_RISK, view->risk) ||
+        nla_put_u32(skb, PROCESS_RISK_A_FLAGS, view->syscalls_exact ? PROCESS_RISK_REC_SYSCALLS_EXACT : 0) ||
+        nla_put_u32(skb, PROCESS_RISK_A_UID, view->uid) ||
+        nla_put_u64_64bit(skb, PROCESS_RISK_A_CGROUP, view->cgroup_id, PROCESS_RISK_A_PAD))
+        return -EMSGSIZE;
+    return 0;
+}
+
+static int process_risk_nl_fill(struct sk_buff *skb, const struct process_risk_view *view,
+                                u32 portid, u32 seq, int flags) {
+    void *hdr = genlmsg_put(skb, portid, seq, &process_risk_genl_family, flags, PROCESS_RISK_CMD_GET);
+
+    if (!hdr)
+        return -EMSGSIZE;
+    if (process_risk_nl_put_view(skb, view)) {
+        genlmsg_cancel(skb, hdr);
+        return -EMSGSIZE;
+    }
+    genlmsg_end(skb, hdr);
+    return 0;
+}
+
+static void process_risk_nl_parse_filter(struct nlattr **attrs, struct process_risk_nl_filter *filter) {
+    memset(filter, 0, sizeof(*filter));
+    if (!attrs)
+        return;
+    if (attrs[PROCESS_RISK_A_UID]) {
+        filter->has_uid = true;
+        filter->uid = nla_get_u32(attrs[PROCESS_RISK_A_UID]);
+    }
+    if (attrs[PROCESS_RISK_A_CGROUP]) {
+        filter->has_cgroup = true;
+        filter->cgroup_id = nla_get_u64(attrs[PROCESS_RISK_A_CGROUP]);
+    }
+    if (attrs[PROCESS_RISK_A_MIN_SCORE])
+        filter->min_score = nla_get_u8(attrs[PROCESS_RISK_A_MIN_SCORE]);
+}
+
+static bool process_risk_nl_match(const struct process_risk_nl_filter *filter,
+                                  const struct process_risk_view *view) {
+    if (filter->has_uid && view->uid != filter->uid)
+        return false;
+    if (filter->has_cgroup && view->cgroup_id != filter->cgroup_id)
+        return false;
+    return view->score >= filter->min_score;
+}
+
+// PROCESS_RISK_CMD_GET com PROCESS_RISK_A_PID: responde com a entrada de um processo
+static int process_risk_nl_get(struct sk_buff *skb, struct genl_info *info) {
+    struct process_risk_info *entry;
+    struct process_risk_view view;
+    struct sk_buff *msg;
+    bool found = false;
+    int ret;
+
+    if (!info->attrs[PROCESS_RISK_A_PID])
+        return -EINVAL;
+
+    rcu_read_lock();
+    entry = process_info_lookup(nla_get_u32(info->attrs[PROCESS_RISK_A_PID]));
+    if (entry) {
+        process_info_read(entry, &view);
+        found = true;
+    }
+    rcu_read_unlock();
+    if (!found)
+        return -ESRCH;
+
+    msg = genlmsg_new(NLMSG_DEFAULT_SIZE, GFP_KERNEL);
+    if (!msg)
+        return -ENOMEM;
+    ret = process_risk_nl_fill(msg, &view, info->snd_portid, info->snd_seq, 0);
+    if (ret) {
+        nlmsg_free(msg);
+        return ret;
+    }
+    return genlmsg_reply(msg, info);
+}
+
+// dump da tabela: percorre o índice hash sob RCU e retoma de (bucket, posição na cadeia),
+// guardados em cb->args, quando a mensagem anterior encheu. os filtros são aplicados
+// antes da cópia, então registros descartados nunca saem do kernel.
+static int process_risk_nl_dump(struct sk_buff *skb, struct netlink_callback *cb) {
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 2, 0)
+    struct nlattr **attrs = genl_dumpit_info(cb)->info.attrs;
+#else
+    struct nlattr **attrs = genl_dumpit_info(cb)->attrs;
+#endif
+    struct process_risk_nl_filter filter;
+    struct process_risk_info *info;
+    struct process_risk_view view;
+    unsigned long bkt = cb->args[0];
+    unsigned int slot = cb->args[1];
+    unsigned int pos;
+
+    process_risk_nl_parse_filter(attrs, &filter);
 
-struct process_risk_info {
-    pid_t pid;      
-    char comm[TASK_COMM_LEN];            // nome do processo
-
-    // métricas cumulativas brutas do kernel (ex: tempo de CPU em nano segundos)
-    u64 current_utime_ns;
-    u64 current_stime_ns;
-    u64 current_read_bytes;
-    u64 current_write_bytes;
-    unsigned long current_min_flt;
-    unsigned long current_maj_flt;
-
-    // métricas cumulativas da leitura anterior (para cálculo de deltas)
-    u64 prev_utime_ns;
-    u64 prev_stime_ns;
-    u64 prev_read_bytes;
-    u64 prev_write_bytes;
-    unsigned long prev_min_flt;
-    unsigned long prev_maj_flt;
-
-    // métricas calculadas como deltas (uso no último intervalo de 5s)
-    unsigned long cpu_delta_ms;         // uso de CPU em millissegundos
-    unsigned long syscalls_delta;       // estimativa de chamadadas de sistema com base em page/faults
-                                        // (não é uma contagem exata, mas uma aproximação)
-    unsigned long io_delta_kb;          // E/S total em KB no intervalo
-    unsigned long mem_rss_mb;           // memória fisica RSS em MB (é um valor instantâneo, não um delta)
+    rcu_read_lock();
+    for (; bkt < HASH_SIZE(process_info_hash); bkt++, slot = 0) {
+        pos = 0;
+        hlist_for_each_entry_rcu(info, &process_info_hash[bkt], hnode) {
+            if (pos++ < slot)
+                continue;
+            process_info_read(info, &view);
+            if (!process_risk_nl_match(&filter, &view))
+                continue;
+            if (process_risk_nl_fill(skb, &view, NETLINK_CB(cb->skb).portid, cb->nlh->nlmsg_seq,
+                                     NLM_F_MULTI)) {
+                slot = pos - 1;
+                goto out;
+            }
+        }
+    }
+out:
+    rcu_read_unlock();
+    cb->args[0] = bkt;
+    cb->args[1] = slot;
+    return skb->len;
+}
 
-    char risk_level[10];                // variável para armazenar o nível de risco do processo
-                                        // "Baixo", "Médio" ou "Alto"
-    struct list_head list;              // nó para a lista encadeada do kernel
+// envia o alerta de mudança de nível ao grupo multicast, se alguém estiver inscrito.
+// roda com stat_lock de escrita, então não pode dormir.
+static void process_risk_nl_alert(const struct process_risk_view *view, u8 old_risk, u64 now_ns) {
+    struct sk_buff *msg;
+    void *hdr;
+
+    if (!genl_has_listeners(&process_risk_genl_family, &init_net, 0))
+        return;
+
+    msg = genlmsg_new(NLMSG_DEFAULT_SIZE, GFP_ATOMIC);
+    if (!msg)
+        return;
+    hdr = genlmsg_put(msg, 0, 0, &process_risk_genl_family, 0, PROCESS_RISK_CMD_ALERT);
+    if (!hdr)
+        goto err;
+    if (process_risk_nl_put_view(msg, view) ||
+        nla_put_u8(msg, PROCESS_RISK_A_OLD_RISK, old_risk) ||
+        nla_put_u64_64bit(msg, PROCESS_RISK_A_TIMESTAMP, now_ns, PROCESS_RISK_A_PAD))
+        goto err;
+    genlmsg_end(msg, hdr);
+
+    genlmsg_multicast(&process_risk_genl_family, msg, 0, 0, GFP_ATOMIC);
+    return;
+err:
+    nlmsg_free(msg);
+}
+
+static const struct genl_ops process_risk_genl_ops[] = {
+    {
+        .cmd    = PROCESS_RISK_CMD_GET,
+        .doit   = process_risk_nl_get,
+        .dumpit = process_risk_nl_dump,
+    },
 };
 
-// variáveis globais para o diretório /proc, timer, lista de processos e mutex
-static struct proc_dir_entry *parent_dir;
-static struct timer_list monitor_timer;
-static LIST_HEAD(process_info_list); 
-static DEFINE_MUTEX(process_info_mutex);
+static const struct genl_multicast_group process_risk_genl_mcgrps[] = {
+    { .name = PROCESS_RISK_GENL_MCGRP_ALERTS },
+};
 
-// definições dos limiares para a avaliação de risco (valores para deltas e RSS)
-#define CPU_DELTA_MEDIUM_THRESHOLD_MS  200
-#define CPU_DELTA_HIGH_THRESHOLD_MS    800
+static struct genl_family process_risk_genl_family = {
+    .name      = PROCESS_RISK_GENL_NAME,
+    .version   = PROCESS_RISK_GENL_VERSION,
+    .maxattr   = PROCESS_RISK_A_MAX,
+    .policy    = process_risk_nl_policy,
+    .module    = THIS_MODULE,
+    .ops       = process_risk_genl_ops,
+    .n_ops     = ARRAY_SIZE(process_risk_genl_ops),
+    .mcgrps    = process_risk_genl_mcgrps,
+    .n_mcgrps  = ARRAY_SIZE(process_risk_genl_mcgrps),
+};
 
-#define SYSCALLS_DELTA_MEDIUM_THRESHOLD  500
-#define SYSCALLS_DELTA_HIGH_THRESHOLD    3000
+// fluxo de eventos de mudança de nível (/proc/process_risk/events). cada descritor aberto
+// tem um anel próprio; a varredura só copia o evento para os anéis com espaço e conta como
+// perdido nos cheios, sem nunca esperar pelos leitores.
+struct risk_event_reader {
+    struct list_head node;
+    unsigned int head;          // próxima posição escrita
+    unsigned int tail;          // próxima posição lida
+    unsigned int mask;
+    u32 dropped;                // perdidos desde o último evento entregue
+    struct process_risk_event ring[];
+};
 
-#define IO_DELTA_MEDIUM_THRESHOLD_KB   500
-#define IO_DELTA_HIGH_THRESHOLD_KB     2000
+static DECLARE_WAIT_QUEUE_HEAD(event_wait);
 
-#define MEM_RSS_MEDIUM_THRESHOLD_MB  350
-#define MEM_RSS_HIGH_THRESHOLD_MB    600
+// publica a mudança de nível de uma entrada para todos os leitores e para o grupo
+// multicast de alertas. chamada pela varredura com stat_lock de escrita, então as
+// métricas lidas aqui são as que geraram a mudança.
+static void risk_event_emit(const struct process_risk_info *info, u8 old_risk, u64 now_ns) {
+    struct process_risk_view view;
+    struct process_risk_event ev;
+    struct risk_event_reader *r;
+    unsigned long flags;
 
-#define TOTAL_SCORE_MEDIUM_RISK 1  // pontuação mínima para risco médio
-#define TOTAL_SCORE_HIGH_RISK   4  // pontuação mínima para risco alto
+    process_info_copy(info, &view);
+    process_risk_nl_alert(&view, old_risk, now_ns);
 
-static void evaluate_and_set_risk(struct process_risk_info *info) {
-    int score = 0;
+    ev = (struct process_risk_event) {
+        .timestamp_ns   = now_ns,
+        .start_time_ns  = view.start_time_ns,
+        .pid            = view.pid,
+        .old_risk       = old_risk,
+        .new_risk       = view.risk,
+        .score          = view.score,
+        .flags          = view.syscalls_exact ? PROCESS_RISK_REC_SYSCALLS_EXACT : 0,
+        .cpu_delta_ms   = view.cpu_delta_ms,
+        .syscalls_delta = view.syscalls_delta,
+        .io_delta_kb    = view.io_delta_kb,
+        .mem_rss_mb     = view.mem_rss_mb,
+        .nr_threads     = view.nr_threads,
+    };
+    memcpy(ev.comm, view.comm, sizeof(ev.comm));
 
-    // pontua o risco com base nas métricas delta de CPU, chamadas de sistema e E/S
-    // e no valor absoluto de memória RSS.
-    if (info->cpu_delta_ms > CPU_DELTA_HIGH_THRESHOLD_MS) {
-        score += 2; // Alta pontuação
-    } else if (info->cpu_delta_ms > CPU_DELTA_MEDIUM_THRESHOLD_MS) {
-        score += 1; // Média pontuação
+    spin_lock_irqsave(&event_lock, flags);
+    events_emitted++;
+    list_for_each_entry(r, &event_readers, node) {
+        if (r->head - r->tail > r->mask) {
+            r->dropped++;
+            events_dropped++;
+            continue;
+        }
+        ev.dropped = r->dropped;
+        r->dropped = 0;
+        r->ring[r->head & r->mask] = ev;
+        r->head++;
     }
+    spin_unlock_irqrestore(&event_lock, flags);
+
+    wake_up_interruptible(&event_wait);
+}
+
+static bool risk_event_pending(struct risk_event_reader *r) {
+    return READ_ONCE(r->head) != READ_ONCE(r->tail);
+}
+
+static int events_open(struct inode *inode, struct file *file) {
+    unsigned int size = roundup_pow_of_two(clamp_val(READ_ONCE(events_ring), 1, EVENTS_RING_MAX));
+    struct risk_event_reader *r;
+
+    r = kvzalloc(struct_size(r, ring, size), GFP_KERNEL);
+    if (!r)
+        return -ENOMEM;
+    r->mask = size - 1;
+
+    spin_lock_irq(&event_lock);
+    list_add_tail(&r->node, &event_readers);
+    event_reader_count++;
+    spin_unlock_irq(&event_lock);
+
+    file->private_data = r;
+    return stream_open(inode, file);
+}
+
+static int events_release(struct inode *inode, struct file *file) {
+    struct risk_event_reader *r = file->private_data;
 
-    if (info->syscalls_delta > SYSCALLS_DELTA_HIGH_THRESHOLD) {
-        score += 2;
-    } else if (info->syscalls_delta > SYSCALLS_DELTA_MEDIUM_THRESHOLD) {
-        score += 1;
+    spin_lock_irq(&event_lock);
+    list_del(&r->node);
+    event_reader_count--;
+    spin_unlock_irq(&event_lock);
+
+    kvfree(r);
+    return 0;
+}
+
+// entrega tantos eventos inteiros quanto couberem em count; bloqueia se não houver nenhum,
+// a menos que o descritor seja O_NONBLOCK
+static ssize_t events_read(struct file *file, char __user *buf, size_t count, loff_t *ppos) {
+    struct risk_event_reader *r = file->private_data;
+    struct process_risk_event ev;
+    size_t copied = 0;
+    int ret;
+
+    if (count < sizeof(ev))
+        return -EINVAL;
+
+    while (copied + sizeof(ev) <= count) {
+        spin_lock_irq(&event_lock);
+        if (r->head == r->tail) {
+            spin_unlock_irq(&event_lock);
+            if (copied)
+                break;
+            if (file->f_flags & O_NONBLOCK)
+                return -EAGAIN;
+            ret = wait_event_interruptible(event_wait, risk_event_pending(r));
+            if (ret)
+                return ret;
+            continue;
+        }
+        ev = r->ring[r->tail & r->mask];
+        r->tail++;
+        spin_unlock_irq(&event_lock);
+
+        if (copy_to_user(buf + copied, &ev, sizeof(ev)))
+            return copied ? copied : -EFAULT;
+        copied += sizeof(ev);
     }
+    return copied;
+}
+
+static __poll_t events_poll(struct file *file, poll_table *wait) {
+    struct risk_event_reader *r = file->private_data;
+
+    poll_wait(file, &event_wait, wait);
+    return risk_event_pending(r) ? EPOLLIN | EPOLLRDNORM : 0;
+}
+
+static const struct file_operations events_file_ops = {
+    .owner   = THIS_MODULE,
+    .open    = events_open,
+    .read    = events_read,
+    .poll    = events_poll,
+    .release = events_release,
+};
+
+/*
+ * Sistema de arquivos process_risk, montado sobre /proc/process_risk.
+ *
+ * Os arquivos <pid> (na raiz e em history/) não existem até alguém procurá-los: o lookup
+ * e o readdir de cada diretório consultam o índice hash, e os inodes/dentries criados para
+ * um <pid> são descartados assim que deixam de ser usados (simple_dentry_operations apaga
+ * o dentry no último dput).
+ * O worker e os tracepoints nunca criam nem removem objetos do VFS. Sem a montagem, os
+ * arquivos fixos continuam disponíveis como entradas do procfs (process_risk_proc_init).
+ */
+static struct inode *process_risk_new_inode(struct super_block *sb, umode_t mode, unsigned long ino) {
+    struct inode *inode = new_inode(sb);
 
-    if (info->io_delta_kb > IO_DELTA_HIGH_THRESHOLD_KB) {
-        score += 2;
-    } else if (info->io_delta_kb > IO_DELTA_MEDIUM_THRESHOLD_KB) {
-        score += 1;
+    if (!inode)
+        return NULL;
+
+    inode->i_ino = ino;
+    inode->i_mode = mode;
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 7, 0)
+    simple_inode_init_ts(inode);
+#else
+    inode->i_atime = inode->i_mtime = inode->i_ctime = current_time(inode);
+#endif
+    return inode;
+}
+
+static bool process_risk_parse_pid(const struct qstr *name, pid_t *pid) {
+    char buf[16];
+    int value;
+
+    if (name->len >= sizeof(buf))
+        return false;
+    memcpy(buf, name->name, name->len);
+    buf[name->len] = '\0';
+    if (kstrtoint(buf, 10, &value) || value <= 0)
+        return false;
+    *pid = value;
+    return true;
+}
+
+// diretório de arquivos <pid> resolvidos sob demanda a partir do índice hash: a raiz
+// expõe as métricas atuais e history/ o histórico de cada processo
+struct process_risk_pid_dir {
+    const struct file_operations *fops;
+    unsigned long ino_offset;           // números de inode dos <pid> = pid + offset
+    loff_t first_pos;                   // posição do primeiro <pid> no readdir
+};
+
+// o inode de um <pid> guarda a chave (PID, início) da instância encontrada no lookup,
+// liberada em process_risk_evict_inode
+static struct dentry *process_risk_lookup_pid(struct inode *dir, struct dentry *dentry, unsigned int flags) {
+    const struct process_risk_pid_dir *pd = dir->i_private;
+    struct process_risk_pid_key *key;
+    struct process_risk_info *info;
+    struct inode *inode;
+    pid_t pid;
+
+    if (!process_risk_parse_pid(&dentry->d_name, &pid))
+        return NULL;
+
+    key = kmalloc(sizeof(*key), GFP_KERNEL);
+    if (!key)
+        return ERR_PTR(-ENOMEM);
+    key->pid = pid;
+
+    rcu_read_lock();
+    info = process_info_lookup(pid);
+    if (info)
+        key->start_time_ns = info->start_time_ns;
+    rcu_read_unlock();
+    if (!info) {
+        kfree(key);
+        return NULL;
     }
 
-    if (info->mem_rss_mb > MEM_RSS_HIGH_THRESHOLD_MB) {
-        score += 2;
-    } else if (info->mem_rss_mb > MEM_RSS_MEDIUM_THRESHOLD_MB) {
-        score += 1;
+    inode = process_risk_new_inode(dir->i_sb, S_IFREG | 0444, pid + pd->ino_offset);
+    if (!inode) {
+        kfree(key);
+        return ERR_PTR(-ENOMEM);
     }
+    inode->i_fop = pd->fops;
+    inode->i_private = key;
+    return d_splice_alias(inode, dentry);
+}
 
-    // define o nível de risco com base na pontuação total
-    if (score >= TOTAL_SCORE_HIGH_RISK) {
-        strncpy(info->risk_level, "Alto", sizeof(info->risk_level) - 1);
-    } else if (score >= TOTAL_SCORE_MEDIUM_RISK) {
-        strncpy(info->risk_level, "Médio", sizeof(info->risk_level) - 1);
-    } else {
-        strncpy(info->risk_level, "Baixo", sizeof(info->risk_level) - 1);
+// a partir de pd->first_pos, a posição do readdir codifica (bucket << 16 | índice na
+// cadeia) do índice hash
+static int process_risk_readdir_pids(struct file *file, struct dir_context *ctx) {
+    const struct process_risk_pid_dir *pd = file_inode(file)->i_private;
+
+    for (;;) {
+        loff_t idx = ctx->pos - pd->first_pos;
+        unsigned long bkt = idx >> 16;
+        unsigned int slot = idx & 0xffff;
+        pid_t pids[PROCESS_RISK_READDIR_BATCH];
+        struct process_risk_info *info;
+        unsigned int pos = 0;
+        int n = 0, i;
+
+        if (bkt >= HASH_SIZE(process_info_hash))
+            break;
+
+        rcu_read_lock();
+        hlist_for_each_entry_rcu(info, &process_info_hash[bkt], hnode) {
+            if (pos++ < slot)
+                continue;
+            if (n == PROCESS_RISK_READDIR_BATCH)
+                break;
+            pids[n++] = info->pid;
+        }
+        rcu_read_unlock();
+
+        // dir_emit copia para o espaço do usuário e pode dormir, então roda fora da seção RCU
+        for (i = 0; i < n; i++) {
+            char name[16];
+            int len = snprintf(name, sizeof(name), "%d", pids[i]);
+
+            if (!dir_emit(ctx, name, len, pids[i] + pd->ino_offset, DT_REG))
+                return 0;
+            ctx->pos++;
+        }
+
+        if (n < PROCESS_RISK_READDIR_BATCH)
+            ctx->pos = pd->first_pos + ((loff_t)(bkt + 1) << 16);
     }
-    info->risk_level[sizeof(info->risk_level) - 1] = '\0';
+    return 0;
 }
 
-// função de callback para leitura do arquivo /proc/process_risk/<pid>
-static int proc_pid_show(struct seq_file *m, void *v) {
-    struct process_risk_info *info = (struct process_risk_info *)m->private;
+static const struct process_risk_pid_dir history_pid_dir = {
+    .fops       = &history_file_ops,
+    .ino_offset = PROCESS_RISK_HISTORY_INO_OFFSET,
+    .first_pos  = 2,
+};
 
-    if (!info) {
-        return -ESRCH;  // garantindo que a informação nao é invalida
+static int process_risk_history_readdir(struct file *file, struct dir_context *ctx) {
+    if (!dir_emit_dots(file, ctx))
+        return 0;
+    return process_risk_readdir_pids(file, ctx);
+}
+
+static const struct inode_operations process_risk_history_iops = {
+    .lookup = process_risk_lookup_pid,
+};
+
+static const struct file_operations process_risk_history_ops = {
+    .owner          = THIS_MODULE,
+    .read           = generic_read_dir,
+    .iterate_shared = process_risk_history_readdir,
+    .llseek         = generic_file_llseek,
+};
+
+// entradas fixas da raiz do sistema de arquivos; os <pid> vêm depois delas no readdir
+struct process_risk_file {
+    const char *name;
+    const struct file_operations *fops;
+    const size_t *size;                         // tamanho exibido no inode, quando fixo
+    const struct inode_operations *iops;        // presente nos diretórios
+    const struct process_risk_pid_dir *pid_dir; // <pid> listados pelo diretório
+};
+
+static const struct process_risk_file process_risk_files[] = {
+    { "stats",    &stats_file_ops },
+    { "top",      &top_file_ops },
+    { "snapshot", &snapshot_file_ops, &snapshot_size },
+    { "events",   &events_file_ops },
+    { "cgroups",  &cgroups_file_ops },
+    { "history",  &process_risk_history_ops, NULL, &process_risk_history_iops, &history_pid_dir },
+};
+
+#define PROCESS_RISK_FILES_POS 2  // posição da primeira entrada fixa no readdir (após . e ..)
+#define PROCESS_RISK_PIDS_POS  (PROCESS_RISK_FILES_POS + ARRAY_SIZE(process_risk_files))
+
+static const struct process_risk_pid_dir root_pid_dir = {
+    .fops       = &pid_file_ops,
+    .ino_offset = PROCESS_RISK_PID_INO_OFFSET,
+    .first_pos  = PROCESS_RISK_PIDS_POS,
+};
+
+static struct dentry *process_risk_lookup(struct inode *dir, struct dentry *dentry, unsigned int flags) {
+    const struct process_risk_file *f;
+    struct inode *inode;
+    int i;
+
+    for (i = 0; i < ARRAY_SIZE(process_risk_files); i++) {
+        f = &process_risk_files[i];
+        if (dentry->d_name.len != strlen(f->name) || memcmp(dentry->d_name.name, f->name, dentry->d_name.len))
+            continue;
+        inode = process_risk_new_inode(dir->i_sb, f->iops ? S_IFDIR | 0555 : S_IFREG | 0444,
+                                       PROCESS_RISK_FILES_POS + i);
+        if (!inode)
+            return ERR_PTR(-ENOMEM);
+        inode->i_fop = f->fops;
+        if (f->size)
+            inode->i_size = *f->size;
+        if (f->iops) {
+            inode->i_op = f->iops;
+            inode->i_private = (void *)f->pid_dir;
+            set_nlink(inode, 2);
+        }
+        return d_splice_alias(inode, dentry);
     }
 
-    mutex_lock(&process_info_mutex);    // bloqueia o mutex para acesso seguro à estrutura de dados
+    return process_risk_lookup_pid(dir, dentry, flags);
+}
 
-    // exibe as informações do processo e o risco atribuido formatadas no arquivo em /proc/process_risk/<pid>
-    seq_printf(m,
-        "PID: %d\n"
-        "Nome: %s\n"
-        "Uso de CPU (delta ms/5s): %lu\n"
-        "Chamadas de Sistema (delta aprox/5s): %lu\n"
-        "E/S Total (delta KB/5s): %lu\n"
-        "Memória (MB): %lu\n"
-        "Risco: %s\n----------------------------------------------------------------\n",
-        info->pid,
-        info->comm,
-        info->cpu_delta_ms,
-        info->syscalls_delta,
-        info->io_delta_kb,
-        info->mem_rss_mb,
-        info->risk_level
-    );
+// posições do readdir: 0 e 1 são "." e "..", depois as entradas fixas e, a partir de
+// PROCESS_RISK_PIDS_POS, os <pid>
+static int process_risk_readdir(struct file *file, struct dir_context *ctx) {
+    if (!dir_emit_dots(file, ctx))
+        return 0;
 
-    mutex_unlock(&process_info_mutex);  // libera o mutex após a leitura
+    while (ctx->pos < PROCESS_RISK_PIDS_POS) {
+        const struct process_risk_file *f = &process_risk_files[ctx->pos - PROCESS_RISK_FILES_POS];
 
+        if (!dir_emit(ctx, f->name, strlen(f->name), ctx->pos, f->iops ? DT_DIR : DT_REG))
+            return 0;
+        ctx->pos++;
+    }
+
+    return process_risk_readdir_pids(file, ctx);
+}
+
+static const struct inode_operations process_risk_dir_iops = {
+    .lookup = process_risk_lookup,
+};
+
+static const struct file_operations process_risk_dir_ops = {
+    .owner          = THIS_MODULE,
+    .read           = generic_read_dir,
+    .iterate_shared = process_risk_readdir,
+    .llseek         = generic_file_llseek,
+};
+
+// libera a chave dos inodes <pid>; os demais apontam para dados estáticos
+static void process_risk_evict_inode(struct inode *inode) {
+    truncate_inode_pages_final(&inode->i_data);
+    clear_inode(inode);
+    if (inode->i_ino >= PROCESS_RISK_PID_INO_OFFSET)
+        kfree(inode->i_private);
+}
+
+static const struct super_operations process_risk_super_ops = {
+    .statfs      = simple_statfs,
+    .drop_inode  = generic_delete_inode,
+    .evict_inode = process_risk_evict_inode,
+};
+
+static int process_risk_fill_super(struct super_block *sb, struct fs_context *fc) {
+    struct inode *root;
+
+    sb->s_blocksize = PAGE_SIZE;
+    sb->s_blocksize_bits = PAGE_SHIFT;
+    sb->s_magic = PROCESS_RISK_FS_MAGIC;
+    sb->s_op = &process_risk_super_ops;
+    sb->s_d_op = &simple_dentry_operations;
+    sb->s_time_gran = 1;
+
+    root = process_risk_new_inode(sb, S_IFDIR | 0555, 1);
+    if (!root)
+        return -ENOMEM;
+    root->i_op = &process_risk_dir_iops;
+    root->i_fop = &process_risk_dir_ops;
+    root->i_private = (void *)&root_pid_dir;
+    set_nlink(root, 3);  // ".", ".." e history/
+
+    sb->s_root = d_make_root(root);
+    if (!sb->s_root)
+        return -ENOMEM;
     return 0;
 }
 
-// função de abertura para o arquivo /proc/process_risk/<pid>
-static int proc_pid_open(struct inode *inode, struct file *file) {
-    struct process_risk_info *info = pde_data(inode);
-    return single_open(file, proc_pid_show, info);
+static int process_risk_get_tree(struct fs_context *fc) {
+    return get_tree_single(fc, process_risk_fill_super);
+}
+
+static const struct fs_context_operations process_risk_context_ops = {
+    .get_tree = process_risk_get_tree,
+};
+
+static int process_risk_init_fs_context(struct fs_context *fc) {
+    fc->ops = &process_risk_context_ops;
+    return 0;
 }
 
-// definição das operações do arquivo para as entradas /proc/process_risk/<pid>
-static const struct proc_ops pid_file_ops = {
-    .proc_open    = proc_pid_open,
-    .proc_read    = seq_read,
-    .proc_lseek   = seq_lseek,
-    .proc_release = single_release,
+static struct file_system_type process_risk_fs_type = {
+    .owner           = THIS_MODULE,
+    .name            = "process_risk",
+    .init_fs_context = process_risk_init_fs_context,
+    .kill_sb         = kill_anon_super,
 };
+MODULE_ALIAS_FS("process_risk");
+
+// contador de cache misses de hardware ligado à thread do worker durante a varredura.
+// devolve NULL se a CPU ou a configuração do kernel não oferecerem o evento.
+static struct perf_event *scan_perf_begin(void) {
+    struct perf_event_attr attr = {
+        .type         = PERF_TYPE_HARDWARE,
+        .config       = PERF_COUNT_HW_CACHE_MISSES,
+        .size         = sizeof(attr),
+        .exclude_user = 1,
+    };
+    struct perf_event *event;
+
+    event = perf_event_create_kernel_counter(&attr, -1, current, NULL, NULL);
+    return IS_ERR(event) ? NULL : event;
+}
+
+static s64 scan_perf_end(struct perf_event *event) {
+    u64 enabled, running, value;
+
+    if (!event)
+        return -1;
+    value = perf_event_read_value(event, &enabled, &running);
+    perf_event_release_kernel(event);
+    return value;
+}
+
+// escolhe a faixa da entrada após uma coleta: risco alto, mudança de pontuação ou CPU
+// longe da média vão para a faixa rápida; sem CPU, E/S nem syscalls por IDLE_STREAK_MIN
+// coletas seguidas, para a ociosa
+static void process_info_set_tier(struct process_risk_info *info, u8 old_score) {
+    u32 cpu_avg = ewma_metric_read(&info->avg.cpu);
+    u32 cpu_swing = max(info->cpu_delta_ms, cpu_avg) - min(info->cpu_delta_ms, cpu_avg);
+
+    if (!info->cpu_delta_ms && !info->io_delta_kb && !info->syscalls_delta) {
+        if (info->idle_streak < U8_MAX)
+            info->idle_streak++;
+    } else {
+        info->idle_streak = 0;
+    }
+
+    if (info->risk == RISK_HIGH || info->score != old_score || cpu_swing > CPU_DELTA_MEDIUM_THRESHOLD_MS)
+        info->tier = TIER_HOT;
+    else if (info->idle_streak >= IDLE_STREAK_MIN)
+        info->tier = TIER_IDLE;
+    else
+        info->tier = TIER_NORMAL;
+}
 
-// função de callback do timer: executa periodicamente para monitorar e atualizar processos
-static void monitor_processes_callback(struct timer_list *t) {
+// atualiza uma entrada a partir da sua task; se o processo não existe mais (ou o PID
+// foi reutilizado sem que a saída fosse vista), retira a entrada do índice. mudanças de
+// nível geram um evento; a avaliação inicial feita ao criar a entrada não gera.
+static void process_info_update(struct process_risk_info *info, u64 now_ns, u64 generation) {
     struct task_struct *task;
-    struct process_risk_info *info, *temp;
-    LIST_HEAD(existing_process_list_snapshot);
+    struct cgroup_contrib old;
+    enum process_filter_reason reason = FILTER_PASS;
+    u8 old_risk, old_score;
 
-    mutex_lock(&process_info_mutex); // novamente um mutex para modifiar a lista principal de processos existentes
+    task = pid_task(find_pid_ns(info->pid, &init_pid_ns), PIDTYPE_PID);
 
-    list_splice_init(&process_info_list, &existing_process_list_snapshot);
+    // os filtros mudaram desde que a entrada foi aceita: reavalia antes de coletar
+    if (task && info->filter_gen != READ_ONCE(filter_generation)) {
+        info->filter_gen = READ_ONCE(filter_generation);
+        reason = process_filter_check(task);
+    }
 
-    rcu_read_lock(); // bloqueia a leitura RCU para garantir que a lista de processos não seja modificada enquanto iteramos
-    // percorre todos os processos do sistema para iterar para calculo de deltas
-    for_each_process(task) {
-        bool found = false;
-        list_for_each_entry_safe(info, temp, &existing_process_list_snapshot, list) {
-            if (info->pid == task->pid) {
-                found = true;
-                
-                info->prev_utime_ns = info->current_utime_ns;
-                info->prev_stime_ns = info->current_stime_ns;
-                info->prev_read_bytes = info->current_read_bytes;
-                info->prev_write_bytes = info->current_write_bytes;
-                info->prev_min_flt = info->current_min_flt;
-                info->prev_maj_flt = info->current_maj_flt;
-
-                info->current_utime_ns = task->utime;
-                info->current_stime_ns = task->stime;
-                info->current_read_bytes = task->ioac.read_bytes;
-                info->current_write_bytes = task->ioac.write_bytes;
-                info->current_min_flt = task->min_flt;
-                info->current_maj_flt = task->maj_flt;
-                
-                u64 total_current_cpu_ns = info->current_utime_ns + info->current_stime_ns;
-                u64 total_prev_cpu_ns = info->prev_utime_ns + info->prev_stime_ns;
-                u64 cpu_delta_ns = 0;
-                if (total_current_cpu_ns > total_prev_cpu_ns) {
-                    cpu_delta_ns = total_current_cpu_ns - total_prev_cpu_ns;
-                }
-                info->cpu_delta_ms = (unsigned long)(cpu_delta_ns / 1000000ULL);
-
-                info->syscalls_delta = (info->current_min_flt + info->current_maj_flt) -
-                                       (info->prev_min_flt + info->prev_maj_flt);
-                info->io_delta_kb = ((info->current_read_bytes + info->current_write_bytes) -
-                                     (info->prev_read_bytes + info->prev_write_bytes)) >> 10;
-                
-                // coleta o valor da memoria RSS em MB (valor instantâneo)
-                info->mem_rss_mb = 0;
-                if (task->mm) {
-                    info->mem_rss_mb = (get_mm_rss(task->mm) * PAGE_SIZE) >> 20;
-                }
-                
-                evaluate_and_set_risk(info);
-
-                list_move_tail(&info->list, &process_info_list); 
-                break;
+    if (task && task->start_time == info->start_time_ns && reason == FILTER_PASS) {
+        info->last_seen_scan = generation;
+        write_seqlock(&info->stat_lock);
+        old_risk = info->risk;
+        old_score = info->score;
+        cgroup_contrib_get(info, &old);
+        if (process_info_refresh(info, task, now_ns)) {
+            cgroup_risk_account(info, &old);
+            evaluate_and_set_risk(info);
+            process_info_set_tier(info, old_score);
+            if (info->risk != old_risk) {
+                trace_process_risk_transition(info->pid, info->comm, old_risk, info->risk, info->score);
+                risk_event_emit(info, old_risk, now_ns);
             }
         }
+        info->next_sample_ns = now_ns + tier_period_ns(info->tier);
+        write_sequnlock(&info->stat_lock);
+        return;
+    }
+
+    spin_lock(&process_info_lock);
+    if (reason != FILTER_PASS)
+        filter_skipped[reason]++;
+    if (!info->exited)
+        process_info_retire(info);
+    spin_unlock(&process_info_lock);
+}
+
+// coleta a faixa do lote atribuída ao shard. entradas retiradas durante o tick continuam
+// válidas, pois só o worker as libera, depois que os shards terminam; o RCU protege a busca
+// da task em process_info_update
+static void scan_shard_work(struct work_struct *work) {
+    struct scan_shard *shard = container_of(work, struct scan_shard, work);
+    struct process_risk_info *info;
+    unsigned long i;
+
+    rcu_read_lock();
+    for (i = shard->first; i < shard->last; i++) {
+        info = scan_batch[i];
+        if (!READ_ONCE(info->exited))
+            process_info_update(info, shard->now_ns, shard->generation);
+        if (!((i - shard->first + 1) % SHARD_MIN_ENTRIES))
+            cond_resched_rcu();
+    }
+    rcu_read_unlock();
+}
+
+static void tier_list_add(struct process_risk_info *info) {
+    list_add_tail(&info->tier_node, &tier_lists[info->tier]);
+    tier_count[info->tier]++;
+}
+
+static void tier_list_del(struct process_risk_info *info) {
+    if (list_empty(&info->tier_node))
+        return;
+    list_del_init(&info->tier_node);
+    tier_count[info->tier]--;
+}
+
+// garante espaço no lote para todas as entradas das listas; se a alocação falhar, o lote
+// fica com a capacidade anterior e o que não couber espera o próximo tick
+static unsigned long scan_batch_reserve(void) {
+    unsigned long want = tier_count[TIER_HOT] + tier_count[TIER_NORMAL] + tier_count[TIER_IDLE];
+    struct process_risk_info **batch;
+
+    if (want <= scan_batch_cap)
+        return scan_batch_cap;
+    want = roundup_pow_of_two(want);
+    batch = kvmalloc_array(want, sizeof(*batch), GFP_KERNEL);
+    if (batch) {
+        kvfree(scan_batch);
+        scan_batch = batch;
+        scan_batch_cap = want;
+    }
+    return scan_batch_cap;
+}
+
+// retira das listas as entradas vencidas, a faixa rápida primeiro, até o limite do tick.
+// cada lista para na primeira entrada que ainda não venceu, então o custo é proporcional às
+// coletas do tick e não ao tamanho da tabela. uma mudança de período em execução deixa a
+// lista fora de ordem só até as entradas antigas vencerem. devolve o tamanho do lote.
+static unsigned long scan_collect_due(u64 now_ns, unsigned long quota, bool *limited) {
+    unsigned long limit = scan_batch_reserve();
+    struct process_risk_info *info, *tmp;
+    unsigned long n = 0;
+    int t;
 
-        // se o processo não foi encontrado na lista, cria o mesmo e coleta as informações
-        if (!found) {
-            struct process_risk_info *new_info = kmalloc(sizeof(*new_info), GFP_ATOMIC);
-            if (new_info) {
-                new_info->pid = task->pid;
-                strncpy(new_info->comm, task->comm, TASK_COMM_LEN - 1);
-                new_info->comm[TASK_COMM_LEN - 1] = '\0';
-
-                new_info->current_utime_ns = task->utime;
-                new_info->current_stime_ns = task->stime;
-                new_info->current_read_bytes = task->ioac.read_bytes;
-                new_info->current_write_bytes = task->ioac.write_bytes;
-                new_info->current_min_flt = task->min_flt;
-                new_info->current_maj_flt = task->maj_flt;
-
-                new_info->prev_utime_ns = new_info->current_utime_ns;
-                new_info->prev_stime_ns = new_info->current_stime_ns;
-                new_info->prev_read_bytes = new_info->current_read_bytes;
-                new_info->prev_write_bytes = new_info->current_write_bytes;
-                new_info->prev_min_flt = new_info->current_min_flt;
-                new_info->prev_maj_flt = new_info->current_maj_flt;
-                
-                new_info->cpu_delta_ms = 0;
-                new_info->syscalls_delta = 0;
-                new_info->io_delta_kb = 0;
-
-                new_info->mem_rss_mb = 0;
-                if (task->mm) {
-                    new_info->mem_rss_mb = (get_mm_rss(task->mm) * PAGE_SIZE) >> 20;
-                }
-                
-                evaluate_and_set_risk(new_info);
-
-                list_add_tail(&new_info->list, &process_info_list);
-                
-                char filename[16];
-                snprintf(filename, sizeof(filename), "%d", new_info->pid);
-                if (!proc_create_data(filename, 0444, parent_dir, &pid_file_ops, new_info)) {
-                     pr_warn("Falha ao criar /proc/%s/%d para novo processo. Removendo da lista.\n", PROC_DIRNAME, new_info->pid);
-                     list_del(&new_info->list);
-                     kfree(new_info);
-                }
-            } else {
-                pr_err("Falha ao alocar memória para novo processo.\n");
+    if (quota && quota < limit)
+        limit = quota;
+    *limited = false;
+
+    for (t = 0; t < NR_TIERS; t++) {
+        list_for_each_entry_safe(info, tmp, &tier_lists[t], tier_node) {
+            if (READ_ONCE(info->exited)) {
+                tier_list_del(info);    // liberada na limpeza deste tick
+                continue;
+            }
+            if (info->next_sample_ns > now_ns)
+                break;
+            if (n == limit) {
+                *limited = true;
+                return n;
             }
+            tier_list_del(info);
+            scan_batch[n++] = info;
+        }
+    }
+    return n;
+}
+
+// quantos shards usar: limitado por scan_cpus, pelas CPUs online e pelo tamanho do lote,
+// para não pagar o custo de despachar trabalho em várias CPUs com poucas entradas
+static unsigned int scan_shard_count(unsigned long entries) {
+    unsigned int n = num_online_cpus();
+    unsigned int cap = READ_ONCE(scan_cpus);
+    unsigned long by_size = entries / SHARD_MIN_ENTRIES + 1;
+
+    if (cap && cap < n)
+        n = cap;
+    if (by_size < n)
+        n = by_size;
+    return max(n, 1U);
+}
+
+// coletas permitidas neste tick pelo orçamento (0 = sem limite)
+static unsigned long scan_tick_quota(void) {
+    unsigned int budget = READ_ONCE(scan_budget);
+
+    if (!budget)
+        return 0;
+    return max_t(unsigned long, (unsigned long)budget * monitor_tick_ms() / MSEC_PER_SEC, 1);
+}
+
+// fase paralela: retira as entradas vencidas das listas de faixa, divide o lote entre os
+// shards, cada um em uma CPU, e devolve as entradas à lista da faixa escolhida na coleta.
+// devolve o número de entradas atualizadas.
+static unsigned long scan_shards_run(u64 now_ns, u64 generation) {
+    unsigned int n, i = 0, cpu;
+    unsigned long count, j;
+    bool limited;
+
+    count = scan_collect_due(now_ns, scan_tick_quota(), &limited);
+    if (limited)
+        scan_budget_limited++;
+
+    cpus_read_lock();
+    n = count ? min(scan_shard_count(count), num_online_cpus()) : 0;
+
+    for_each_online_cpu(cpu) {
+        struct scan_shard *shard = &scan_shards[i];
+
+        if (i == n)
+            break;
+        shard->first = count * i / n;
+        shard->last = count * (i + 1) / n;
+        shard->now_ns = now_ns;
+        shard->generation = generation;
+        queue_work_on(cpu, shard_wq, &shard->work);
+        i++;
+    }
+
+    for (i = 0; i < n; i++)
+        flush_work(&scan_shards[i].work);
+    cpus_read_unlock();
+
+    // entradas retiradas durante a coleta não voltam: são liberadas na limpeza
+    for (j = 0; j < count; j++) {
+        if (!READ_ONCE(scan_batch[j]->exited))
+            tier_list_add(scan_batch[j]);
+    }
+
+    scan_last_shards = n;
+    return count;
+}
+
+// reescreve o snapshot binário com a tabela atual. seq fica ímpar durante a escrita para
+// que os leitores do mapeamento detectem cópias inconsistentes e repitam a leitura.
+static void snapshot_publish(u64 generation) {
+    struct process_risk_snapshot_header *hdr = snapshot_buf;
+    struct process_risk_record *rec = snapshot_buf + sizeof(*hdr);
+    struct process_risk_info *info;
+    struct process_risk_view view;
+    u32 count = 0, dropped = 0;
+
+    lockdep_assert_held(&process_info_mutex);
+
+    WRITE_ONCE(hdr->seq, hdr->seq + 1);
+    smp_wmb();
+
+    list_for_each_entry(info, &process_info_list, list) {
+        if (count == hdr->capacity) {
+            dropped++;
+            continue;
         }
+        process_info_read(info, &view);
+        rec[count++] = (struct process_risk_record) {
+            .start_time_ns  = view.start_time_ns,
+            .pid            = view.pid,
+            .cpu_delta_ms   = view.cpu_delta_ms,
+            .syscalls_delta = view.syscalls_delta,
+            .io_delta_kb    = view.io_delta_kb,
+            .mem_rss_mb     = view.mem_rss_mb,
+            .nr_threads     = view.nr_threads,
+            .score          = view.score,
+            .risk           = view.risk,
+            .flags          = view.syscalls_exact ? PROCESS_RISK_REC_SYSCALLS_EXACT : 0,
+        };
+        memcpy(rec[count - 1].comm, view.comm, sizeof(rec->comm));
+    }
+
+    hdr->count = count;
+    hdr->dropped = dropped;
+    hdr->generation = generation;
+    hdr->timestamp_ns = ktime_get_ns();
+    hdr->interval_ms = READ_ONCE(interval_ms);
+
+    smp_wmb();
+    WRITE_ONCE(hdr->seq, hdr->seq + 1);
+}
+
+// registra a duração de uma fase e devolve o instante atual, início da próxima fase
+static u64 scan_phase_end(enum scan_phase phase, u64 start_ns) {
+    u64 now_ns = ktime_get_ns();
+    u64 ns = now_ns - start_ns;
+    u64 us = div_u64(ns, NSEC_PER_USEC);
+    struct scan_hist *hist = &scan_hist[phase];
+
+    hist->buckets[us ? min_t(unsigned int, ilog2(us) + 1, SCAN_HIST_BUCKETS - 1) : 0]++;
+    if (ns > hist->max_ns)
+        hist->max_ns = ns;
+    return now_ns;
+}
+
+// função do worker: executa periodicamente em contexto de processo. a criação e a saída
+// de processos chegam pelos tracepoints; as métricas são atualizadas em paralelo pelos
+// shards e, no final, o worker incorpora as entradas novas e libera as retiradas.
+static void monitor_processes_work(struct work_struct *work) {
+    struct process_risk_info *info, *temp;
+    struct llist_node *retired;
+    LIST_HEAD(new_info_list);
+    unsigned long tasks_seen = 0;
+    unsigned long refreshed;
+    unsigned long deferred = 0;
+    unsigned long created = 0, freed = 0;
+    bool reconcile;
+    u64 scan_start_ns, scan_ns, phase_ns;
+    struct perf_event *perf;
+
+    mutex_lock(&process_info_mutex); // novamente um mutex para modifiar a lista principal de processos existentes
+
+    spare_info_refill();
+
+    perf = scan_perf_begin();
+    scan_start_ns = ktime_get_ns();
+    scan_generation++;
+
+    spin_lock(&process_info_lock);
+    reconcile = cap_retry_due() || reconcile_pending;
+    reconcile_pending = false;
+    spin_unlock(&process_info_lock);
+
+    trace_process_risk_scan_start(scan_generation, READ_ONCE(tracked_count), reconcile);
+
+    phase_ns = scan_start_ns;
+    if (reconcile)
+        tasks_seen = process_info_reconcile(scan_start_ns, &deferred);
+    process_info_enforce_cap();
+    phase_ns = scan_phase_end(SCAN_PHASE_WALK, phase_ns);
+
+    // soma as contagens de syscalls de cada CPU antes de calcular os deltas
+    if (syscall_probe_active)
+        on_each_cpu(syscall_slots_flush_cpu, NULL, 1);
+    phase_ns = scan_phase_end(SCAN_PHASE_MATCH, phase_ns);
+
+    refreshed = scan_shards_run(scan_start_ns, scan_generation);
+    if (!reconcile)
+        tasks_seen = refreshed;
+    phase_ns = scan_phase_end(SCAN_PHASE_REFRESH, phase_ns);
+
+    cgroup_risk_update();
+    phase_ns = scan_phase_end(SCAN_PHASE_CGROUPS, phase_ns);
+
+    // fase de junção: pendentes e retiradas são capturadas juntas sob o spinlock, então
+    // toda entrada retirada já está em process_info_list ou em new_info_list
+    spin_lock(&process_info_lock);
+    list_splice_tail_init(&pending_info_list, &new_info_list);
+    retired = llist_del_all(&retired_info_list);
+    spin_unlock(&process_info_lock);
+
+    // as novas entram no início da lista normal, já vencidas (next_sample_ns = 0)
+    list_for_each_entry(info, &new_info_list, list) {
+        list_add(&info->tier_node, &tier_lists[info->tier]);
+        tier_count[info->tier]++;
+        created++;
     }
-    rcu_read_unlock();  // libera a leitura RCU após iterar por todos os processos
+    list_splice_tail_init(&new_info_list, &process_info_list);
 
-    // remove os processos que não estão mais ativos e libera a memória
-    list_for_each_entry_safe(info, temp, &existing_process_list_snapshot, list) {
-        pr_info("Processo %d (%s) terminado. Removendo entrada /proc.\n", info->pid, info->comm);
-        char filename[16];
-        snprintf(filename, sizeof(filename), "%d", info->pid);
-        remove_proc_entry(filename, parent_dir);
+    // libera os processos terminados; eles já saíram do índice, mas leitores que os
+    // encontraram antes ainda podem estar copiando as métricas
+    llist_for_each_entry_safe(info, temp, retired, retire_node) {
+        tier_list_del(info);
         list_del(&info->list);
-        kfree(info);
+        call_rcu(&info->rcu, process_info_free_rcu);
+        freed++;
     }
+    phase_ns = scan_phase_end(SCAN_PHASE_CLEANUP, phase_ns);
+
+    // o snapshot percorre a tabela inteira, então é publicado no intervalo normal e não a
+    // cada tick da faixa rápida
+    if (scan_start_ns >= snapshot_next_ns) {
+        snapshot_publish(scan_generation);
+        snapshot_next_ns = scan_start_ns + (u64)READ_ONCE(interval_ms) * NSEC_PER_MSEC;
+        scan_phase_end(SCAN_PHASE_PUBLISH, phase_ns);
+    }
+
+    // registra o custo da varredura para /proc/process_risk/stats e debugfs
+    scan_ns = scan_phase_end(SCAN_PHASE_TOTAL, scan_start_ns) - scan_start_ns;
+    scan_cache_misses = scan_perf_end(perf);
+    scan_last_ns = scan_ns;
+    scan_total_ns += scan_ns;
+    if (scan_ns > scan_max_ns)
+        scan_max_ns = scan_ns;
+    scan_last_tasks = tasks_seen;
+    scan_deferred_tasks = deferred;
+    scan_last_created = created;
+    scan_last_retired = freed;
+    scan_total_created += created;
+    scan_total_retired += freed;
+    scan_total_seen += tasks_seen;
+
+    trace_process_risk_scan_end(scan_generation, scan_ns, tasks_seen, refreshed, created, freed);
+
+    // agenda a próxima varredura com o intervalo atual, a menos que o módulo esteja saindo
+    if (monitor_wq)
+        queue_delayed_work(monitor_wq, &monitor_work, msecs_to_jiffies(monitor_tick_ms()));
 
     mutex_unlock(&process_info_mutex); // libera o mutex 
+}
+
+// sem a montagem, os arquivos servidos direto do índice, sem lookup por nome (stats, top,
+// cgroups, snapshot e events), são entradas comuns do procfs criadas uma única vez na carga;
+// só os <pid> e history/ dependem do sistema de arquivos. montado sobre /proc/process_risk,
+// ele esconde estas entradas e serve os mesmos arquivos.
+static const struct proc_ops snapshot_proc_ops = {
+    .proc_mmap = snapshot_mmap,
+};
 
-    mod_timer(&monitor_timer, jiffies + MONITOR_INTERVAL_JIFFIES); // reinicia o timer para o próximo monitoramento
+static const struct proc_ops events_proc_ops = {
+    .proc_open    = events_open,
+    .proc_read    = events_read,
+    .proc_poll    = events_poll,
+    .proc_release = events_release,
+};
+
+static int process_risk_proc_init(void) {
+    struct proc_dir_entry *snapshot;
+
+    parent_dir = proc_mkdir(PROC_DIRNAME, NULL);
+    if (!parent_dir)
+        return -ENOMEM;
+
+    if (!proc_create_single("stats", 0444, parent_dir, proc_stats_show) ||
+        !proc_create_single("top", 0444, parent_dir, proc_top_show) ||
+        !proc_create_single("cgroups", 0444, parent_dir, proc_cgroups_show) ||
+        !proc_create("events", 0444, parent_dir, &events_proc_ops))
+        goto err;
+
+    snapshot = proc_create("snapshot", 0444, parent_dir, &snapshot_proc_ops);
+    if (!snapshot)
+        goto err;
+    proc_set_size(snapshot, snapshot_size);
+    return 0;
+
+err:
+    proc_remove(parent_dir);
+    return -ENOMEM;
+}
+
+// aloca o snapshot binário e preenche os campos fixos do cabeçalho
+static int snapshot_init(void) {
+    struct process_risk_snapshot_header *hdr;
+    u32 capacity = clamp_val(snapshot_entries, 1, SNAPSHOT_ENTRIES_MAX);
+
+    snapshot_size = PAGE_ALIGN(sizeof(*hdr) + (size_t)capacity * sizeof(struct process_risk_record));
+    snapshot_buf = vmalloc_user(snapshot_size);
+    if (!snapshot_buf) {
+        pr_err("Falha ao alocar o snapshot (%zu bytes)\n", snapshot_size);
+        return -ENOMEM;
+    }
+
+    hdr = snapshot_buf;
+    hdr->magic = PROCESS_RISK_SNAPSHOT_MAGIC;
+    hdr->version = PROCESS_RISK_SNAPSHOT_VERSION;
+    hdr->header_size = sizeof(*hdr);
+    hdr->record_size = sizeof(struct process_risk_record);
+    hdr->capacity = (snapshot_size - sizeof(*hdr)) / sizeof(struct process_risk_record);
+    return 0;
 }
 
-// função de inicialização do módulo: cria o diretório /proc/process_risk e inicia o timer
+// função de inicialização do módulo: cria /proc/process_risk com os arquivos fixos,
+// registra o sistema de arquivos que pode ser montado sobre ele e inicia o worker
 static int __init process_risk_init(void) {
+    struct workqueue_struct *wq;
+    unsigned int i;
+    int ret;
+
     pr_info("Iniciando módulo process_risk_monitor...\n");
 
-    parent_dir = proc_mkdir(PROC_DIRNAME, NULL);
-    if (!parent_dir) {
-        pr_err("Falha ao criar /proc/%s\n", PROC_DIRNAME);
+    process_info_cachep = KMEM_CACHE(process_risk_info, SLAB_HWCACHE_ALIGN);
+    if (!process_info_cachep) {
+        pr_err("Falha ao criar o cache de entradas\n");
         return -ENOMEM;
     }
 
-    timer_setup(&monitor_timer, monitor_processes_callback, 0);
-    mod_timer(&monitor_timer, jiffies + HZ);
+    ret = snapshot_init();
+    if (ret)
+        goto err_cache;
+
+    ret = process_risk_proc_init();
+    if (ret) {
+        pr_err("Falha ao criar /proc/%s\n", PROC_DIRNAME);
+        goto err_snapshot;
+    }
+
+    ret = register_filesystem(&process_risk_fs_type);
+    if (ret) {
+        pr_err("Falha ao registrar o sistema de arquivos process_risk (%d)\n", ret);
+        goto err_proc;
+    }
+
+    INIT_DELAYED_WORK(&monitor_work, monitor_processes_work);
+
+    scan_shards = kcalloc(nr_cpu_ids, sizeof(*scan_shards), GFP_KERNEL);
+    if (!scan_shards) {
+        ret = -ENOMEM;
+        goto err_fs;
+    }
+    for (i = 0; i < nr_cpu_ids; i++)
+        INIT_WORK(&scan_shards[i].work, scan_shard_work);
+
+    shard_wq = alloc_workqueue("process_risk_shard", 0, 0);
+    if (!shard_wq) {
+        pr_err("Falha ao criar a workqueue dos shards\n");
+        ret = -ENOMEM;
+        goto err_shards;
+    }
+
+    wq = alloc_ordered_workqueue("process_risk", 0);
+    if (!wq) {
+        pr_err("Falha ao criar a workqueue do monitor\n");
+        ret = -ENOMEM;
+        goto err_shard_wq;
+    }
+
+    ret = genl_register_family(&process_risk_genl_family);
+    if (ret) {
+        pr_err("Falha ao registrar a família generic netlink (%d)\n", ret);
+        goto err_wq;
+    }
+
+    // os tracepoints são registrados antes da primeira varredura completa, assim nenhum
+    // processo criado durante a carga do módulo fica de fora
+    ret = register_tracepoints();
+    if (ret)
+        goto err_genl;
+
+    mutex_lock(&process_info_mutex);
+    ret = syscall_probe_update();
+    if (ret) {
+        mutex_unlock(&process_info_mutex);
+        goto err_tp;
+    }
+    monitor_wq = wq;
+    queue_delayed_work(monitor_wq, &monitor_work, 0);
+    mutex_unlock(&process_info_mutex);
 
-    pr_info("Módulo process_risk_monitor carregado e monitoramento iniciado.\n");
+    process_risk_debugfs_init();
+
+    pr_info("Módulo process_risk_monitor carregado. Para os <pid> e history/: mount -t process_risk none /proc/%s\n", PROC_DIRNAME);
     return 0;
+
+err_tp:
+    unregister_tracepoints();
+err_genl:
+    genl_unregister_family(&process_risk_genl_family);
+err_wq:
+    destroy_workqueue(wq);
+err_shard_wq:
+    destroy_workqueue(shard_wq);
+err_shards:
+    kfree(scan_shards);
+err_fs:
+    unregister_filesystem(&process_risk_fs_type);
+err_proc:
+    proc_remove(parent_dir);
+err_snapshot:
+    vfree(snapshot_buf);
+err_cache:
+    kmem_cache_destroy(process_info_cachep);
+    process_filter_free();  // filtros passados no insmod
+    return ret;
 }
 
-// função de limpeza do módulo: remove o diretório /proc/process_risk e libera a memória
-// além de parar o timer e remover as entradas de processos monitorados
-// e liberar a memória alocada para cada entrada de processo
+// função de limpeza do módulo: para os tracepoints e o worker, remove o sistema de arquivos
+// e o diretório /proc/process_risk e libera a memória de cada entrada de processo monitorado.
+// enquanto o sistema de arquivos estiver montado o módulo não pode ser descarregado.
 static void __exit process_risk_exit(void) {
     struct process_risk_info *info, *temp;
+    struct cgroup_risk *cg, *cg_tmp;
+    struct workqueue_struct *wq;
 
     pr_info("Descarregando módulo process_risk_monitor...\n");
 
-    del_timer_sync(&monitor_timer);
-
     mutex_lock(&process_info_mutex);
+    wq = monitor_wq;
+    monitor_wq = NULL;  // impede que o worker ou os parâmetros reagendem a varredura ou religuem probes
+    count_syscalls = false;
+    syscall_probe_update();
+    mutex_unlock(&process_info_mutex);
+
+    unregister_tracepoints();
+
+    cancel_delayed_work_sync(&monitor_work);
+    destroy_workqueue(wq);
+    destroy_workqueue(shard_wq);
+    kfree(scan_shards);
+    kvfree(scan_batch);
 
+    // a varredura parada não emite mais alertas; dumps em andamento terminam antes do retorno
+    genl_unregister_family(&process_risk_genl_family);
+    unregister_filesystem(&process_risk_fs_type);
+    debugfs_remove_recursive(process_risk_debugfs);
+
+    // remove os arquivos do procfs, esperando os leitores que estiverem ativos (stats lê o
+    // cabeçalho do snapshot, então o buffer só é liberado depois)
+    proc_remove(parent_dir);
+    vfree(snapshot_buf);
+
+    // com os tracepoints e o worker parados e os arquivos removidos,
+    // nada mais altera as listas nem lê as entradas
+    list_splice_tail_init(&pending_info_list, &process_info_list);
     list_for_each_entry_safe(info, temp, &process_info_list, list) {
-        pr_info("Removendo entrada /proc/%s/%d\n", PROC_DIRNAME, info->pid);
-        char filename[16];
-        snprintf(filename, sizeof(filename), "%d", info->pid);
-        remove_proc_entry(filename, parent_dir);
+        hash_del(&info->hnode);
         list_del(&info->list);
-        kfree(info);
+        kmem_cache_free(process_info_cachep, info);
     }
+    tracked_count = 0;
+    spare_info_free_all();
 
-    mutex_unlock(&process_info_mutex);
+    list_for_each_entry_safe(cg, cg_tmp, &cgroup_risk_list, list) {
+        hash_del(&cg->hnode);
+        list_del(&cg->list);
+        kfree(cg);
+    }
 
-    remove_proc_entry(PROC_DIRNAME, NULL);
+    rcu_barrier();  // espera os call_rcu pendentes antes de destruir o cache
+    kmem_cache_destroy(process_info_cachep);
+    process_filter_free();
 
     pr_info("Módulo process_risk_monitor descarregado.\n");
 }
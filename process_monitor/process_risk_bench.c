@@ -0,0 +1,228 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <search.h>
+#include <time.h>
+
+#include "process_risk_score.h"
+
+// microbenchmark no espaço do usuário das operações que a varredura faz por processo:
+//  - coleta: cada rodada gera novos contadores cumulativos para N processos sintéticos e
+//    chama risk_refresh e risk_averages_score, as mesmas funções de process_risk_score.h
+//    que o módulo usa (deltas, normalização, médias, tendência de memória e pontuação);
+//  - tabela: inserção, busca e remoção no índice por PID, com o mesmo número de buckets e
+//    a mesma função de hash do módulo, e a atualização do índice top, uma árvore
+//    rubro-negra ordenada por pontuação (aqui a tsearch da glibc).
+//   process_risk_bench              1k, 10k e 100k processos
+//   process_risk_bench N...         só os tamanhos dados
+
+#define BENCH_OPS    20000000UL    // coletas e buscas por tamanho (as rodadas se ajustam a N)
+#define BENCH_ELAPSED_NS 5000000000ULL
+
+#define PROCESS_HASH_BITS 12       // como no módulo: 4096 buckets
+#define GOLDEN_RATIO_32 0x61C88647
+
+// nó de lista com ponteiro para o ponteiro anterior, como hlist_node
+struct bench_hnode {
+    struct bench_hnode *next;
+    struct bench_hnode **pprev;
+};
+
+// só os campos que a coleta, o índice e a pontuação usam, como em process_risk_info
+struct bench_entry {
+    struct bench_hnode hnode;      // primeiro campo: o nó é o endereço da entrada
+    u32 pid;
+    struct risk_counters prev;
+    struct risk_deltas d;
+    struct risk_averages avg;
+    u8 score;
+    u8 risk;
+};
+
+static struct bench_hnode *bench_hash[1 << PROCESS_HASH_BITS];
+static void *bench_top;
+
+static uint64_t rng_state = 88172645463325252ULL;
+
+static uint64_t rng_next(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// novos valores cumulativos de uma entrada; de vez em quando um contador volta, como
+// num PID reutilizado sem que a saída fosse vista
+static void bench_sample(const struct bench_entry *e, uint64_t r, struct risk_counters *cur) {
+    cur->cpu_ns = e->prev.cpu_ns + (r & 0x3fffffff);
+    cur->io_bytes = e->prev.io_bytes + ((r >> 30) & 0xfffff);
+    cur->events = e->prev.events + ((r >> 50) & 0x3ff);
+    cur->rss_kb = e->prev.rss_kb + ((r >> 20) & 0xff);
+    cur->rss_kb = cur->rss_kb > 1024 + 0x7f ? cur->rss_kb - 0x7f : 1024;
+    if (!(r & 0xffff0000000ULL))
+        cur->cpu_ns = cur->io_bytes = cur->events = 0;
+}
+
+// o mesmo caminho de process_info_refresh e evaluate_and_set_risk no módulo
+static void bench_update(struct bench_entry *e, const struct risk_counters *cur, u64 elapsed_ns) {
+    int score;
+
+    risk_refresh(&e->d, &e->avg, &e->prev, cur, elapsed_ns);
+    e->prev = *cur;
+    score = risk_averages_score(&e->avg, e->d.rss_mb);
+    e->score = score;
+    e->risk = risk_level(score);
+}
+
+static unsigned int bench_hash_bucket(u32 pid) {
+    return (pid * GOLDEN_RATIO_32) >> (32 - PROCESS_HASH_BITS);
+}
+
+static void bench_hash_add(struct bench_entry *e) {
+    struct bench_hnode **head = &bench_hash[bench_hash_bucket(e->pid)];
+
+    e->hnode.next = *head;
+    if (*head)
+        (*head)->pprev = &e->hnode.next;
+    e->hnode.pprev = head;
+    *head = &e->hnode;
+}
+
+static struct bench_entry *bench_hash_lookup(u32 pid) {
+    struct bench_hnode *node;
+
+    for (node = bench_hash[bench_hash_bucket(pid)]; node; node = node->next) {
+        struct bench_entry *e = (struct bench_entry *)node;
+
+        if (e->pid == pid)
+            return e;
+    }
+    return NULL;
+}
+
+static void bench_hash_del(struct bench_entry *e) {
+    *e->hnode.pprev = e->hnode.next;
+    if (e->hnode.next)
+        e->hnode.next->pprev = e->hnode.pprev;
+}
+
+// ordem do índice top, como top_index_less: pontuação maior primeiro; empate pelo menor PID
+static int bench_top_cmp(const void *a, const void *b) {
+    const struct bench_entry *ea = a, *eb = b;
+
+    if (ea->score != eb->score)
+        return ea->score > eb->score ? -1 : 1;
+    return ea->pid < eb->pid ? -1 : ea->pid > eb->pid;
+}
+
+// como top_index_update: só entradas com pontuação ficam no índice
+static void bench_top_update(struct bench_entry *e, u8 score) {
+    if (e->score)
+        tdelete(e, &bench_top, bench_top_cmp);
+    e->score = score;
+    if (score)
+        tsearch(e, &bench_top, bench_top_cmp);
+}
+
+static int bench_run(unsigned long n) {
+    unsigned long rounds = BENCH_OPS / n ? BENCH_OPS / n : 1;
+    unsigned long levels[3] = { 0 };
+    unsigned long i, round, found = 0;
+    struct bench_entry *table;
+    double start, ns, insert_ns, lookup_ns, top_ns, retire_ns;
+
+    table = calloc(n, sizeof(*table));
+    if (!table) {
+        perror("calloc");
+        return 1;
+    }
+    for (i = 0; i < n; i++) {
+        table[i].pid = i + 1;
+        table[i].prev.rss_kb = (rng_next() & 0xfffff) + 1024;
+        risk_averages_init(&table[i].avg);
+    }
+
+    start = now_ns();
+    for (round = 0; round < rounds; round++) {
+        for (i = 0; i < n; i++) {
+            struct bench_entry *e = &table[i];
+            struct risk_counters cur;
+
+            bench_sample(e, rng_next(), &cur);
+            bench_update(e, &cur, BENCH_ELAPSED_NS);
+        }
+    }
+    ns = now_ns() - start;
+
+    for (i = 0; i < n; i++)
+        levels[table[i].risk]++;
+
+    printf("%8lu processos: %6lu rodadas, %7.1f ns/coleta, %8.3f ms/varredura (baixo/médio/alto: %lu/%lu/%lu)\n",
+           n, rounds, ns / ((double)n * rounds), ns / rounds / 1e6,
+           levels[RISK_LOW], levels[RISK_MEDIUM], levels[RISK_HIGH]);
+
+    // índice por PID e índice top, na ordem em que a tabela os usa: a entrada é publicada,
+    // consultada, reposicionada a cada mudança de pontuação e retirada na saída
+    for (i = 0; i < n; i++)
+        table[i].score = 0;
+
+    start = now_ns();
+    for (i = 0; i < n; i++)
+        bench_hash_add(&table[i]);
+    insert_ns = (now_ns() - start) / n;
+
+    start = now_ns();
+    for (i = 0; i < rounds * n; i++)
+        found += bench_hash_lookup(rng_next() % n + 1) != NULL;
+    lookup_ns = (now_ns() - start) / ((double)rounds * n);
+
+    start = now_ns();
+    for (i = 0; i < rounds * n; i++) {
+        uint64_t r = rng_next();
+
+        bench_top_update(&table[r % n], (r >> 32) % 9);
+    }
+    top_ns = (now_ns() - start) / ((double)rounds * n);
+
+    start = now_ns();
+    for (i = 0; i < n; i++) {
+        bench_top_update(&table[i], 0);
+        bench_hash_del(&table[i]);
+    }
+    retire_ns = (now_ns() - start) / n;
+
+    printf("%8lu processos: inserção %6.1f ns, busca %6.1f ns, top %6.1f ns, remoção %6.1f ns por operação%s\n",
+           n, insert_ns, lookup_ns, top_ns, retire_ns,
+           found == rounds * n ? "" : " (busca falhou)");
+    free(table);
+    return found == rounds * n ? 0 : 1;
+}
+
+int main(int argc, char *argv[]) {
+    static const unsigned long sizes[] = { 1000, 10000, 100000 };
+    int i, ret = 0;
+
+    if (argc == 1) {
+        for (i = 0; i < 3; i++)
+            ret |= bench_run(sizes[i]);
+        return ret;
+    }
+
+    for (i = 1; i < argc; i++) {
+        long n = atol(argv[i]);
+
+        if (n < 1) {
+            fprintf(stderr, "Uso: %s [processos...]\n", argv[0]);
+            return 1;
+        }
+        ret |= bench_run(n);
+    }
+    return ret;
+}
@@ -0,0 +1,379 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <linux/genetlink.h>
+
+#include "process_risk_uapi.h"
+
+// cliente da interface generic netlink do process_risk:
+//   process_risk_nl                  despeja a tabela inteira
+//   process_risk_nl -u UID -c ID -s N  despeja só os processos do uid, do cgroup e com pontuação >= N
+//   process_risk_nl -p PID           consulta um processo
+//   process_risk_nl -w               acompanha os alertas de mudança de nível
+//   process_risk_nl -b N             compara N dumps com N leituras de /proc/process_risk/<pid>
+
+#define PROC_DIR  "/proc/process_risk"
+#define BUF_SIZE  (64 * 1024)
+
+static const char *risk_names[] = { "Baixo", "Médio", "Alto" };
+
+struct nl_request {
+    struct nlmsghdr nlh;
+    struct genlmsghdr genl;
+    char attrs[256];
+};
+
+struct record {
+    uint32_t pid, cpu_ms, syscalls, io_kb, mem_mb, threads, uid;
+    uint8_t score, risk, old_risk;
+    uint64_t cgroup;
+    char comm[16];
+};
+
+static int nl_fd;
+static uint16_t family_id;
+static uint32_t alerts_group;
+static uint32_t seq_no;
+
+static void add_attr(struct nl_request *req, uint16_t type, const void *data, uint16_t len) {
+    struct nlattr *nla = (struct nlattr *)((char *)req + NLMSG_ALIGN(req->nlh.nlmsg_len));
+
+    nla->nla_type = type;
+    nla->nla_len = NLA_HDRLEN + len;
+    memcpy((char *)nla + NLA_HDRLEN, data, len);
+    req->nlh.nlmsg_len = NLMSG_ALIGN(req->nlh.nlmsg_len) + NLA_ALIGN(nla->nla_len);
+}
+
+static void init_request(struct nl_request *req, uint16_t type, uint16_t flags, uint8_t cmd, uint8_t version) {
+    memset(req, 0, sizeof(*req));
+    req->nlh.nlmsg_len = NLMSG_LENGTH(GENL_HDRLEN);
+    req->nlh.nlmsg_type = type;
+    req->nlh.nlmsg_flags = NLM_F_REQUEST | flags;
+    req->nlh.nlmsg_seq = ++seq_no;
+    req->genl.cmd = cmd;
+    req->genl.version = version;
+}
+
+static int send_request(struct nl_request *req) {
+    struct sockaddr_nl addr = { .nl_family = AF_NETLINK };
+
+    if (sendto(nl_fd, req, req->nlh.nlmsg_len, 0, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        perror("Erro ao enviar a requisição netlink");
+        return -1;
+    }
+    return 0;
+}
+
+// percorre os atributos de uma mensagem genetlink
+#define for_each_attr(nla, start, len) \
+    for (nla = (struct nlattr *)(start); \
+         (len) >= (int)NLA_HDRLEN && nla->nla_len >= NLA_HDRLEN && nla->nla_len <= (len); \
+         (len) -= NLA_ALIGN(nla->nla_len), nla = (struct nlattr *)((char *)nla + NLA_ALIGN(nla->nla_len)))
+
+#define attr_data(nla) ((void *)((char *)(nla) + NLA_HDRLEN))
+
+// descobre o id da família e do grupo multicast de alertas pelo controlador genetlink
+static int resolve_family(void) {
+    struct nl_request req;
+    char buf[BUF_SIZE];
+    struct nlmsghdr *nlh;
+    struct nlattr *nla, *grp, *field;
+    ssize_t n;
+    int len, glen, flen;
+
+    init_request(&req, GENL_ID_CTRL, 0, CTRL_CMD_GETFAMILY, 1);
+    add_attr(&req, CTRL_ATTR_FAMILY_NAME, PROCESS_RISK_GENL_NAME, strlen(PROCESS_RISK_GENL_NAME) + 1);
+    if (send_request(&req) < 0)
+        return -1;
+
+    n = recv(nl_fd, buf, sizeof(buf), 0);
+    if (n < 0) {
+        perror("Erro ao receber a resposta do controlador");
+        return -1;
+    }
+    nlh = (struct nlmsghdr *)buf;
+    if (!NLMSG_OK(nlh, n) || nlh->nlmsg_type == NLMSG_ERROR) {
+        fprintf(stderr, "Família %s não encontrada (o módulo está carregado?)\n", PROCESS_RISK_GENL_NAME);
+        return -1;
+    }
+
+    len = nlh->nlmsg_len - NLMSG_LENGTH(GENL_HDRLEN);
+    for_each_attr(nla, (char *)NLMSG_DATA(nlh) + GENL_HDRLEN, len) {
+        if (nla->nla_type == CTRL_ATTR_FAMILY_ID)
+            family_id = *(uint16_t *)attr_data(nla);
+        if (nla->nla_type != CTRL_ATTR_MCAST_GROUPS)
+            continue;
+        glen = nla->nla_len - NLA_HDRLEN;
+        for_each_attr(grp, attr_data(nla), glen) {
+            const char *name = NULL;
+            uint32_t id = 0;
+
+            flen = grp->nla_len - NLA_HDRLEN;
+            for_each_attr(field, attr_data(grp), flen) {
+                if (field->nla_type == CTRL_ATTR_MCAST_GRP_NAME)
+                    name = attr_data(field);
+                else if (field->nla_type == CTRL_ATTR_MCAST_GRP_ID)
+                    id = *(uint32_t *)attr_data(field);
+            }
+            if (name && !strcmp(name, PROCESS_RISK_GENL_MCGRP_ALERTS))
+                alerts_group = id;
+        }
+    }
+    return family_id ? 0 : -1;
+}
+
+static void parse_record(struct nlmsghdr *nlh, struct record *rec) {
+    struct nlattr *nla;
+    int len = nlh->nlmsg_len - NLMSG_LENGTH(GENL_HDRLEN);
+
+    memset(rec, 0, sizeof(*rec));
+    for_each_attr(nla, (char *)NLMSG_DATA(nlh) + GENL_HDRLEN, len) {
+        void *d = attr_data(nla);
+
+        switch (nla->nla_type) {
+        case PROCESS_RISK_A_PID:      rec->pid = *(uint32_t *)d; break;
+        case PROCESS_RISK_A_COMM:     snprintf(rec->comm, sizeof(rec->comm), "%s", (char *)d); break;
+        case PROCESS_RISK_A_CPU_MS:   rec->cpu_ms = *(uint32_t *)d; break;
+        case PROCESS_RISK_A_SYSCALLS: rec->syscalls = *(uint32_t *)d; break;
+        case PROCESS_RISK_A_IO_KB:    rec->io_kb = *(uint32_t *)d; break;
+        case PROCESS_RISK_A_MEM_MB:   rec->mem_mb = *(uint32_t *)d; break;
+        case PROCESS_RISK_A_THREADS:  rec->threads = *(uint32_t *)d; break;
+        case PROCESS_RISK_A_UID:      rec->uid = *(uint32_t *)d; break;
+        case PROCESS_RISK_A_SCORE:    rec->score = *(uint8_t *)d; break;
+        case PROCESS_RISK_A_RISK:     rec->risk = *(uint8_t *)d; break;
+        case PROCESS_RISK_A_OLD_RISK: rec->old_risk = *(uint8_t *)d; break;
+        case PROCESS_RISK_A_CGROUP:   memcpy(&rec->cgroup, d, sizeof(rec->cgroup)); break;
+        }
+    }
+}
+
+static void print_record(const struct record *rec) {
+    printf("%-8u %-16s %-6u %-10u %-6s %10u %10u %10u %10u\n",
+           rec->pid, rec->comm, rec->uid, rec->score, risk_names[rec->risk % 3],
+           rec->cpu_ms, rec->syscalls, rec->io_kb, rec->mem_mb);
+}
+
+// recebe as mensagens até NLMSG_DONE (ou a resposta única de um doit); devolve o número
+// de registros recebidos ou -1
+static long receive_records(int print) {
+    char buf[BUF_SIZE];
+    struct nlmsghdr *nlh;
+    struct record rec;
+    long count = 0;
+    ssize_t n;
+
+    for (;;) {
+        n = recv(nl_fd, buf, sizeof(buf), 0);
+        if (n < 0) {
+            perror("Erro ao receber do netlink");
+            return -1;
+        }
+        for (nlh = (struct nlmsghdr *)buf; NLMSG_OK(nlh, n); nlh = NLMSG_NEXT(nlh, n)) {
+            if (nlh->nlmsg_type == NLMSG_DONE)
+                return count;
+            if (nlh->nlmsg_type == NLMSG_ERROR) {
+                struct nlmsgerr *err = NLMSG_DATA(nlh);
+
+                if (err->error) {
+                    fprintf(stderr, "Erro do kernel: %s\n", strerror(-err->error));
+                    return -1;
+                }
+                return count;
+            }
+            count++;
+            if (print) {
+                parse_record(nlh, &rec);
+                print_record(&rec);
+            }
+            if (!(nlh->nlmsg_flags & NLM_F_MULTI))
+                return count;
+        }
+    }
+}
+
+static long dump(long uid, long long cgroup, int min_score, int print) {
+    struct nl_request req;
+
+    init_request(&req, family_id, NLM_F_DUMP, PROCESS_RISK_CMD_GET, PROCESS_RISK_GENL_VERSION);
+    if (uid >= 0) {
+        uint32_t v = uid;
+        add_attr(&req, PROCESS_RISK_A_UID, &v, sizeof(v));
+    }
+    if (cgroup >= 0) {
+        uint64_t v = cgroup;
+        add_attr(&req, PROCESS_RISK_A_CGROUP, &v, sizeof(v));
+    }
+    if (min_score > 0) {
+        uint8_t v = min_score;
+        add_attr(&req, PROCESS_RISK_A_MIN_SCORE, &v, sizeof(v));
+    }
+    if (send_request(&req) < 0)
+        return -1;
+    return receive_records(print);
+}
+
+static int get_pid(uint32_t pid) {
+    struct nl_request req;
+
+    init_request(&req, family_id, 0, PROCESS_RISK_CMD_GET, PROCESS_RISK_GENL_VERSION);
+    add_attr(&req, PROCESS_RISK_A_PID, &pid, sizeof(pid));
+    if (send_request(&req) < 0)
+        return -1;
+    return receive_records(1) == 1 ? 0 : -1;
+}
+
+static int watch_alerts(void) {
+    char buf[BUF_SIZE];
+    struct nlmsghdr *nlh;
+    struct record rec;
+    ssize_t n;
+
+    if (!alerts_group) {
+        fprintf(stderr, "Grupo multicast %s não encontrado\n", PROCESS_RISK_GENL_MCGRP_ALERTS);
+        return -1;
+    }
+    if (setsockopt(nl_fd, SOL_NETLINK, NETLINK_ADD_MEMBERSHIP, &alerts_group, sizeof(alerts_group)) < 0) {
+        perror("Erro ao entrar no grupo de alertas");
+        return -1;
+    }
+
+    for (;;) {
+        n = recv(nl_fd, buf, sizeof(buf), 0);
+        if (n < 0) {
+            perror("Erro ao receber alerta");
+            return -1;
+        }
+        for (nlh = (struct nlmsghdr *)buf; NLMSG_OK(nlh, n); nlh = NLMSG_NEXT(nlh, n)) {
+            parse_record(nlh, &rec);
+            printf("%-8u %-16s %s -> %s (pontuação %u)\n", rec.pid, rec.comm,
+                   risk_names[rec.old_risk % 3], risk_names[rec.risk % 3], rec.score);
+            fflush(stdout);
+        }
+    }
+}
+
+static double now_us(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+// lê todos os /proc/process_risk/<pid>, como um coletor baseado em procfs faria
+static long read_procfs(void) {
+    char path[sizeof(PROC_DIR) + 256], buf[4096];
+    struct dirent *de;
+    long count = 0;
+    DIR *dir;
+    int fd;
+
+    dir = opendir(PROC_DIR);
+    if (!dir)
+        return -1;
+    while ((de = readdir(dir))) {
+        if (de->d_name[0] < '0' || de->d_name[0] > '9')
+            continue;
+        snprintf(path, sizeof(path), PROC_DIR "/%s", de->d_name);
+        fd = open(path, O_RDONLY);
+        if (fd < 0)
+            continue;
+        if (read(fd, buf, sizeof(buf)) > 0)
+            count++;
+        close(fd);
+    }
+    closedir(dir);
+    return count;
+}
+
+static void benchmark(int rounds) {
+    double start, nl_us, proc_us;
+    long records = 0, files = 0;
+    int i;
+
+    start = now_us();
+    for (i = 0; i < rounds; i++)
+        records = dump(-1, -1, 0, 0);
+    nl_us = (now_us() - start) / rounds;
+
+    start = now_us();
+    for (i = 0; i < rounds; i++)
+        files = read_procfs();
+    proc_us = (now_us() - start) / rounds;
+
+    printf("netlink: %ld registros, %.1f us por dump (%.2f us por registro)\n",
+           records, nl_us, records > 0 ? nl_us / records : 0.0);
+    if (files >= 0)
+        printf("procfs:  %ld arquivos, %.1f us por passagem (%.2f us por arquivo)\n",
+               files, proc_us, files > 0 ? proc_us / files : 0.0);
+    else
+        printf("procfs:  %s não está montado\n", PROC_DIR);
+}
+
+int main(int argc, char *argv[]) {
+    struct sockaddr_nl addr = { .nl_family = AF_NETLINK };
+    long uid = -1;
+    long long cgroup = -1;
+    int min_score = 0, rounds = 0, watch = 0;
+    long pid = -1;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "u:c:s:p:wb:")) != -1) {
+        switch (opt) {
+        case 'u': uid = atol(optarg); break;
+        case 'c': cgroup = atoll(optarg); break;
+        case 's': min_score = atoi(optarg); break;
+        case 'p': pid = atol(optarg); break;
+        case 'w': watch = 1; break;
+        case 'b': rounds = atoi(optarg); break;
+        default:
+            fprintf(stderr, "Uso: %s [-u uid] [-c cgroup] [-s pontuação] [-p pid] [-w] [-b rodadas]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    nl_fd = socket(AF_NETLINK, SOCK_RAW, NETLINK_GENERIC);
+    if (nl_fd < 0) {
+        perror("Erro ao abrir o socket netlink");
+        return 1;
+    }
+    if (bind(nl_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        perror("Erro ao associar o socket netlink");
+        close(nl_fd);
+        return 1;
+    }
+    if (resolve_family() < 0) {
+        close(nl_fd);
+        return 1;
+    }
+
+    if (watch)
+        return watch_alerts() < 0;
+    if (rounds > 0) {
+        benchmark(rounds);
+        close(nl_fd);
+        return 0;
+    }
+
+    printf("%-8s %-16s %-6s %-10s %-6s %10s %10s %10s %10s\n",
+           "PID", "Nome", "UID", "Pontuação", "Risco", "CPU(ms)", "Syscalls", "E/S(KB)", "Mem(MB)");
+    if (pid > 0) {
+        if (get_pid(pid) < 0) {
+            close(nl_fd);
+            return 1;
+        }
+    } else if (dump(uid, cgroup, min_score, 1) < 0) {
+        close(nl_fd);
+        return 1;
+    }
+
+    close(nl_fd);
+    return 0;
+}
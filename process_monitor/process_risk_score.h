@@ -0,0 +1,227 @@
+#ifndef PROCESS_RISK_SCORE_H
+#define PROCESS_RISK_SCORE_H
+
+// cálculo dos deltas e da pontuação de risco. as funções não dependem da entrada de
+// processo, de locks nem de tasks: recebem só os valores coletados, então o mesmo código
+// é usado pelo módulo e pode ser incluído por programas no espaço do usuário.
+
+#ifdef __KERNEL__
+#include <linux/types.h>
+#include <linux/limits.h>
+#include <linux/math64.h>
+#include <linux/time64.h>
+#else
+#include <stdint.h>
+
+typedef uint8_t  u8;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int64_t  s64;
+
+#define U32_MAX       UINT32_MAX
+#define NSEC_PER_MSEC 1000000L
+#define NSEC_PER_SEC  1000000000L
+
+static inline u64 mul_u64_u64_div_u64(u64 a, u64 b, u64 c) {
+    return (u64)((unsigned __int128)a * b / c);
+}
+
+static inline u64 div_u64(u64 dividend, u32 divisor) {
+    return dividend / divisor;
+}
+
+static inline s64 div64_s64(s64 dividend, s64 divisor) {
+    return dividend / divisor;
+}
+#endif
+
+#define RISK_WINDOW_NS (5 * NSEC_PER_SEC)  // janela de referência dos deltas e limiares (5s)
+
+// definições dos limiares para a avaliação de risco (valores para deltas e RSS)
+#define CPU_DELTA_MEDIUM_THRESHOLD_MS  200
+#define CPU_DELTA_HIGH_THRESHOLD_MS    800
+
+#define SYSCALLS_DELTA_MEDIUM_THRESHOLD  500
+#define SYSCALLS_DELTA_HIGH_THRESHOLD    3000
+
+#define IO_DELTA_MEDIUM_THRESHOLD_KB   500
+#define IO_DELTA_HIGH_THRESHOLD_KB     2000
+
+#define MEM_RSS_MEDIUM_THRESHOLD_MB  350
+#define MEM_RSS_HIGH_THRESHOLD_MB    600
+
+// crescimento sustentado do RSS (média de longo prazo), para vazamentos lentos
+#define MEM_GROWTH_MEDIUM_THRESHOLD_KB_MIN  1024   // 1 MB/min
+#define MEM_GROWTH_HIGH_THRESHOLD_KB_MIN    10240  // 10 MB/min
+#define MEM_TREND_WEIGHT 16                        // peso 1/16 por amostra (~80s no intervalo padrão)
+
+#define TOTAL_SCORE_MEDIUM_RISK 1  // pontuação mínima para risco médio
+#define TOTAL_SCORE_HIGH_RISK   4  // pontuação mínima para risco alto
+
+#define EWMA_METRIC_PRECISION 8    // bits de fração
+#define EWMA_METRIC_WEIGHT_SHIFT 2 // peso 1/4 por amostra (com o intervalo padrão, ~20s)
+
+enum process_risk_level {
+    RISK_LOW,
+    RISK_MEDIUM,
+    RISK_HIGH,
+};
+
+// média móvel exponencial das métricas de intervalo, em ponto fixo. diferente de
+// <linux/average.h>, onde uma média zerada conta como vazia e a próxima amostra entra
+// inteira, esta começa em zero como um valor de verdade: a primeira amostra de um processo
+// novo entra com 1/4 do valor, e um processo ocioso cuja média voltou a zero também não
+// recebe a rajada seguinte com peso total.
+struct ewma_metric {
+    u64 internal;
+};
+
+static inline void ewma_metric_init(struct ewma_metric *e) {
+    e->internal = 0;
+}
+
+static inline unsigned long ewma_metric_read(const struct ewma_metric *e) {
+    return e->internal >> EWMA_METRIC_PRECISION;
+}
+
+static inline void ewma_metric_add(struct ewma_metric *e, u32 val) {
+    e->internal += (((u64)val << EWMA_METRIC_PRECISION) >> EWMA_METRIC_WEIGHT_SHIFT) -
+                   (e->internal >> EWMA_METRIC_WEIGHT_SHIFT);
+}
+
+// diferença entre duas leituras de um contador cumulativo. um valor menor que o anterior
+// (contador reiniciado, PID reutilizado sem que a saída fosse vista) conta como nenhuma
+// atividade em vez de dar a volta para um delta enorme.
+static inline u64 risk_counter_delta(u64 cur, u64 prev) {
+    return cur > prev ? cur - prev : 0;
+}
+
+// converte um delta medido em elapsed_ns para o equivalente na janela de referência,
+// para que atrasos do worker não inflem nem reduzam os deltas
+static inline u64 risk_normalize_delta(u64 delta, u64 elapsed_ns) {
+    if (!elapsed_ns)
+        return 0;
+    return mul_u64_u64_div_u64(delta, RISK_WINDOW_NS, elapsed_ns);
+}
+
+// as métricas exportadas são u32: satura em vez de truncar os bits altos
+static inline u32 risk_sat_u32(u64 value) {
+    return value > U32_MAX ? U32_MAX : (u32)value;
+}
+
+// acumula o crescimento do RSS normalizado para 5s na média de longo prazo, em ponto
+// fixo (<< 8). prev_kb e cur_kb são leituras do RSS separadas por elapsed_ns.
+static inline s64 risk_mem_trend_update(s64 trend, u32 prev_kb, u32 cur_kb, u64 elapsed_ns) {
+    s64 elapsed_ms = (s64)(elapsed_ns / NSEC_PER_MSEC);
+    s64 growth;
+
+    if (!elapsed_ms)
+        return trend;
+    growth = div64_s64(((s64)cur_kb - prev_kb) * (RISK_WINDOW_NS / NSEC_PER_MSEC), elapsed_ms);
+    return trend + div64_s64(growth * 256 - trend, MEM_TREND_WEIGHT);
+}
+
+// crescimento médio do RSS convertido para KB/min (0 quando a memória não cresce)
+static inline u64 risk_mem_growth_kb_min(s64 trend) {
+    s64 kb = trend / 256;
+
+    return kb > 0 ? (u64)kb * (60 / (RISK_WINDOW_NS / NSEC_PER_SEC)) : 0;
+}
+
+static inline int risk_points(u64 value, u64 medium, u64 high) {
+    if (value > high)
+        return 2; // Alta pontuação
+    if (value > medium)
+        return 1; // Média pontuação
+    return 0;
+}
+
+// soma os pontos de cada métrica; a memória pontua pelo maior entre o valor atual e o
+// crescimento sustentado (growth_kb_min = 0 ignora o crescimento)
+static inline int risk_score(u64 cpu_ms, u64 syscalls, u64 io_kb, u64 rss_mb, u64 growth_kb_min) {
+    int score = 0;
+    int rss_points, growth_points;
+
+    score += risk_points(cpu_ms, CPU_DELTA_MEDIUM_THRESHOLD_MS, CPU_DELTA_HIGH_THRESHOLD_MS);
+    score += risk_points(syscalls, SYSCALLS_DELTA_MEDIUM_THRESHOLD, SYSCALLS_DELTA_HIGH_THRESHOLD);
+    score += risk_points(io_kb, IO_DELTA_MEDIUM_THRESHOLD_KB, IO_DELTA_HIGH_THRESHOLD_KB);
+
+    rss_points = risk_points(rss_mb, MEM_RSS_MEDIUM_THRESHOLD_MB, MEM_RSS_HIGH_THRESHOLD_MB);
+    growth_points = risk_points(growth_kb_min, MEM_GROWTH_MEDIUM_THRESHOLD_KB_MIN,
+                                MEM_GROWTH_HIGH_THRESHOLD_KB_MIN);
+    score += rss_points > growth_points ? rss_points : growth_points;
+    return score;
+}
+
+// define o nível de risco com base na pontuação total
+static inline enum process_risk_level risk_level(int score) {
+    if (score >= TOTAL_SCORE_HIGH_RISK)
+        return RISK_HIGH;
+    if (score >= TOTAL_SCORE_MEDIUM_RISK)
+        return RISK_MEDIUM;
+    return RISK_LOW;
+}
+
+// contadores cumulativos de um processo lidos em uma coleta
+struct risk_counters {
+    u64 cpu_ns;                         // utime + stime
+    u64 io_bytes;                       // read_bytes + write_bytes
+    u64 events;                         // syscalls contadas ou, na falta delas, page faults
+    u32 rss_kb;                         // RSS (valor instantâneo)
+};
+
+// métricas de intervalo de uma coleta, normalizadas para a janela de 5s
+struct risk_deltas {
+    u32 cpu_ms;
+    u32 syscalls;
+    u32 io_kb;
+    u32 rss_mb;
+};
+
+// estado de longo prazo usado na pontuação
+struct risk_averages {
+    struct ewma_metric cpu;             // médias usadas na pontuação, no lugar do último delta
+    struct ewma_metric syscalls;
+    struct ewma_metric io;
+    s64 mem_trend;                      // crescimento médio do RSS em KB/5s, ponto fixo (<< 8)
+};
+
+static inline void risk_averages_init(struct risk_averages *avg) {
+    ewma_metric_init(&avg->cpu);
+    ewma_metric_init(&avg->syscalls);
+    ewma_metric_init(&avg->io);
+    avg->mem_trend = 0;
+}
+
+// uma coleta: deltas entre prev e cur, separadas por elapsed_ns, normalizados para a
+// janela de 5s e acumulados nas médias e na tendência de memória
+static inline void risk_refresh(struct risk_deltas *d, struct risk_averages *avg,
+                                const struct risk_counters *prev,
+                                const struct risk_counters *cur, u64 elapsed_ns) {
+    u64 delta;
+
+    // contadores que voltam (reinício, troca entre contagem real e aproximada) dão delta 0
+    delta = risk_counter_delta(cur->cpu_ns, prev->cpu_ns);
+    d->cpu_ms = risk_sat_u32(div_u64(risk_normalize_delta(delta, elapsed_ns), NSEC_PER_MSEC));
+    delta = risk_counter_delta(cur->io_bytes, prev->io_bytes);
+    d->io_kb = risk_sat_u32(risk_normalize_delta(delta, elapsed_ns) >> 10);
+    delta = risk_counter_delta(cur->events, prev->events);
+    d->syscalls = risk_sat_u32(risk_normalize_delta(delta, elapsed_ns));
+    d->rss_mb = cur->rss_kb >> 10;
+
+    avg->mem_trend = risk_mem_trend_update(avg->mem_trend, prev->rss_kb, cur->rss_kb, elapsed_ns);
+    ewma_metric_add(&avg->cpu, d->cpu_ms);
+    ewma_metric_add(&avg->syscalls, d->syscalls);
+    ewma_metric_add(&avg->io, d->io_kb);
+}
+
+// pontuação das médias e do RSS atual
+static inline int risk_averages_score(const struct risk_averages *avg, u32 rss_mb) {
+    return risk_score(ewma_metric_read(&avg->cpu),
+                      ewma_metric_read(&avg->syscalls),
+                      ewma_metric_read(&avg->io),
+                      rss_mb,
+                      risk_mem_growth_kb_min(avg->mem_trend));
+}
+
+#endif
@@ -0,0 +1,208 @@
+// testes KUnit de process_risk_score.h: deltas de contadores, normalização para a janela
+// de 5s, saturação, médias móveis e limiares da pontuação. rodam com kunit.py (UML/QEMU)
+// ou carregando process_risk_score_test.ko em um kernel com CONFIG_KUNIT.
+
+#include <kunit/test.h>
+#include <linux/module.h>
+
+#include "process_risk_score.h"
+
+#define MB_KB 1024
+
+// contador cumulativo: avanço normal, sem mudança e contador que volta (reinício ou PID
+// reutilizado sem que a saída fosse vista), que não pode dar a volta para um delta enorme
+static void risk_counter_delta_test(struct kunit *test) {
+    KUNIT_EXPECT_EQ(test, risk_counter_delta(150, 100), (u64)50);
+    KUNIT_EXPECT_EQ(test, risk_counter_delta(100, 100), (u64)0);
+    KUNIT_EXPECT_EQ(test, risk_counter_delta(10, 1000), (u64)0);
+    KUNIT_EXPECT_EQ(test, risk_counter_delta(0, U64_MAX), (u64)0);
+    KUNIT_EXPECT_EQ(test, risk_counter_delta(U64_MAX, 0), U64_MAX);
+}
+
+// o delta é convertido para a janela de 5s pelo tempo realmente decorrido
+static void risk_normalize_delta_test(struct kunit *test) {
+    KUNIT_EXPECT_EQ(test, risk_normalize_delta(100, RISK_WINDOW_NS), (u64)100);
+    KUNIT_EXPECT_EQ(test, risk_normalize_delta(100, 2 * RISK_WINDOW_NS), (u64)50);
+    KUNIT_EXPECT_EQ(test, risk_normalize_delta(100, RISK_WINDOW_NS / 2), (u64)200);
+    KUNIT_EXPECT_EQ(test, risk_normalize_delta(100, 0), (u64)0);
+    // o produto intermediário não estoura 64 bits
+    KUNIT_EXPECT_EQ(test, risk_normalize_delta(U64_MAX / 2, 2 * RISK_WINDOW_NS), U64_MAX / 4);
+}
+
+static void risk_sat_u32_test(struct kunit *test) {
+    KUNIT_EXPECT_EQ(test, risk_sat_u32(5), (u32)5);
+    KUNIT_EXPECT_EQ(test, risk_sat_u32(U32_MAX), U32_MAX);
+    KUNIT_EXPECT_EQ(test, risk_sat_u32((u64)U32_MAX + 1), U32_MAX);
+    KUNIT_EXPECT_EQ(test, risk_sat_u32(U64_MAX), U32_MAX);
+}
+
+// média móvel das métricas de intervalo (peso 1/4): começa em zero, então a primeira
+// amostra entra com um quarto do valor, e uma carga sustentada converge para ela. uma média
+// que voltou a zero (processo ocioso) também não recebe a rajada seguinte com peso total
+static void ewma_metric_test(struct kunit *test) {
+    struct ewma_metric avg;
+    int i;
+
+    ewma_metric_init(&avg);
+    KUNIT_EXPECT_EQ(test, ewma_metric_read(&avg), 0UL);
+    ewma_metric_add(&avg, 1000);
+    KUNIT_EXPECT_EQ(test, ewma_metric_read(&avg), 250UL);
+
+    ewma_metric_add(&avg, 1000);
+    KUNIT_EXPECT_EQ(test, ewma_metric_read(&avg), 437UL);
+
+    for (i = 0; i < 40; i++)
+        ewma_metric_add(&avg, 1000);
+    KUNIT_EXPECT_EQ(test, ewma_metric_read(&avg), 1000UL);
+
+    for (i = 0; i < 100; i++)
+        ewma_metric_add(&avg, 0);
+    KUNIT_EXPECT_EQ(test, ewma_metric_read(&avg), 0UL);
+    ewma_metric_add(&avg, 1000);
+    KUNIT_EXPECT_EQ(test, ewma_metric_read(&avg), 250UL);
+
+    // amostras no limite de u32 não estouram o ponto fixo
+    ewma_metric_init(&avg);
+    for (i = 0; i < 100; i++)
+        ewma_metric_add(&avg, U32_MAX);
+    KUNIT_EXPECT_GE(test, ewma_metric_read(&avg), (unsigned long)U32_MAX - 256);
+}
+
+// média de longo prazo do crescimento do RSS (peso 1/16), em ponto fixo (<< 8)
+static void risk_mem_trend_test(struct kunit *test) {
+    s64 trend = 0;
+    int i;
+
+    // 1 MB em 5s: um dezesseis avos do crescimento entra na média
+    trend = risk_mem_trend_update(trend, 100 * MB_KB, 101 * MB_KB, RISK_WINDOW_NS);
+    KUNIT_EXPECT_EQ(test, trend, (s64)(MB_KB * 256 / MEM_TREND_WEIGHT));
+    KUNIT_EXPECT_EQ(test, risk_mem_growth_kb_min(trend), (u64)(MB_KB / MEM_TREND_WEIGHT * 12));
+
+    // sem tempo decorrido a média não muda
+    KUNIT_EXPECT_EQ(test, risk_mem_trend_update(trend, 0, 50 * MB_KB, 0), trend);
+
+    // o mesmo crescimento medido em 10s vale metade
+    KUNIT_EXPECT_EQ(test, risk_mem_trend_update(0, 0, MB_KB, 2 * RISK_WINDOW_NS),
+                    (s64)(MB_KB / 2 * 256 / MEM_TREND_WEIGHT));
+
+    // 1 MB a cada 5s sustentado converge para 12 MB/min, acima do limiar alto
+    for (i = 0; i < 300; i++)
+        trend = risk_mem_trend_update(trend, 100 * MB_KB, 101 * MB_KB, RISK_WINDOW_NS);
+    KUNIT_EXPECT_GT(test, risk_mem_growth_kb_min(trend), (u64)MEM_GROWTH_HIGH_THRESHOLD_KB_MIN);
+
+    // memória encolhendo não pontua
+    trend = risk_mem_trend_update(0, 200 * MB_KB, 100 * MB_KB, RISK_WINDOW_NS);
+    KUNIT_EXPECT_LT(test, trend, (s64)0);
+    KUNIT_EXPECT_EQ(test, risk_mem_growth_kb_min(trend), (u64)0);
+}
+
+// os limiares são estritos: o valor igual ao limiar ainda não pontua
+static void risk_points_test(struct kunit *test) {
+    KUNIT_EXPECT_EQ(test, risk_points(CPU_DELTA_MEDIUM_THRESHOLD_MS, CPU_DELTA_MEDIUM_THRESHOLD_MS,
+                                      CPU_DELTA_HIGH_THRESHOLD_MS), 0);
+    KUNIT_EXPECT_EQ(test, risk_points(CPU_DELTA_MEDIUM_THRESHOLD_MS + 1, CPU_DELTA_MEDIUM_THRESHOLD_MS,
+                                      CPU_DELTA_HIGH_THRESHOLD_MS), 1);
+    KUNIT_EXPECT_EQ(test, risk_points(CPU_DELTA_HIGH_THRESHOLD_MS, CPU_DELTA_MEDIUM_THRESHOLD_MS,
+                                      CPU_DELTA_HIGH_THRESHOLD_MS), 1);
+    KUNIT_EXPECT_EQ(test, risk_points(CPU_DELTA_HIGH_THRESHOLD_MS + 1, CPU_DELTA_MEDIUM_THRESHOLD_MS,
+                                      CPU_DELTA_HIGH_THRESHOLD_MS), 2);
+}
+
+static void risk_score_test(struct kunit *test) {
+    KUNIT_EXPECT_EQ(test, risk_score(0, 0, 0, 0, 0), 0);
+    KUNIT_EXPECT_EQ(test, risk_score(CPU_DELTA_HIGH_THRESHOLD_MS + 1, 0, 0, 0, 0), 2);
+    KUNIT_EXPECT_EQ(test, risk_score(0, SYSCALLS_DELTA_MEDIUM_THRESHOLD + 1, 0, 0, 0), 1);
+    KUNIT_EXPECT_EQ(test, risk_score(0, 0, IO_DELTA_HIGH_THRESHOLD_KB + 1, 0, 0), 2);
+
+    // a memória pontua pelo maior entre o RSS atual e o crescimento, sem somar os dois
+    KUNIT_EXPECT_EQ(test, risk_score(0, 0, 0, MEM_RSS_HIGH_THRESHOLD_MB + 1, 0), 2);
+    KUNIT_EXPECT_EQ(test, risk_score(0, 0, 0, 0, MEM_GROWTH_MEDIUM_THRESHOLD_KB_MIN + 1), 1);
+    KUNIT_EXPECT_EQ(test, risk_score(0, 0, 0, MEM_RSS_MEDIUM_THRESHOLD_MB + 1,
+                                     MEM_GROWTH_HIGH_THRESHOLD_KB_MIN + 1), 2);
+
+    KUNIT_EXPECT_EQ(test, risk_score(U64_MAX, U64_MAX, U64_MAX, U64_MAX, U64_MAX), 8);
+}
+
+static void risk_level_test(struct kunit *test) {
+    KUNIT_EXPECT_EQ(test, risk_level(0), RISK_LOW);
+    KUNIT_EXPECT_EQ(test, risk_level(TOTAL_SCORE_MEDIUM_RISK), RISK_MEDIUM);
+    KUNIT_EXPECT_EQ(test, risk_level(TOTAL_SCORE_HIGH_RISK - 1), RISK_MEDIUM);
+    KUNIT_EXPECT_EQ(test, risk_level(TOTAL_SCORE_HIGH_RISK), RISK_HIGH);
+    KUNIT_EXPECT_EQ(test, risk_level(8), RISK_HIGH);
+}
+
+// um pico isolado de CPU pontua menos pela média do que pelo último delta, inclusive no
+// primeiro intervalo de um processo novo
+static void risk_spike_test(struct kunit *test) {
+    struct ewma_metric cpu;
+    u64 spike = CPU_DELTA_HIGH_THRESHOLD_MS + 1;
+    int i;
+
+    ewma_metric_init(&cpu);
+    for (i = 0; i < 8; i++)
+        ewma_metric_add(&cpu, 10);
+    ewma_metric_add(&cpu, spike);
+
+    KUNIT_EXPECT_EQ(test, risk_score(spike, 0, 0, 0, 0), 2);
+    KUNIT_EXPECT_EQ(test, risk_score(ewma_metric_read(&cpu), 0, 0, 0, 0), 1);
+
+    ewma_metric_init(&cpu);
+    ewma_metric_add(&cpu, spike);
+    KUNIT_EXPECT_EQ(test, risk_score(ewma_metric_read(&cpu), 0, 0, 0, 0), 0);
+}
+
+// uma coleta completa separada por 10s: deltas normalizados para 5s, médias e tendência
+// com o primeiro peso de 1/4, e contadores que voltam sem delta
+static void risk_refresh_test(struct kunit *test) {
+    struct risk_counters prev = { .rss_kb = 100 * MB_KB };
+    struct risk_counters cur = {
+        .cpu_ns   = 4000 * NSEC_PER_MSEC,
+        .io_bytes = 2048 * 1024,
+        .events   = 600,
+        .rss_kb   = 200 * MB_KB,
+    };
+    struct risk_averages avg;
+    struct risk_deltas d;
+
+    risk_averages_init(&avg);
+    risk_refresh(&d, &avg, &prev, &cur, 2 * RISK_WINDOW_NS);
+    KUNIT_EXPECT_EQ(test, d.cpu_ms, (u32)2000);
+    KUNIT_EXPECT_EQ(test, d.io_kb, (u32)1024);
+    KUNIT_EXPECT_EQ(test, d.syscalls, (u32)300);
+    KUNIT_EXPECT_EQ(test, d.rss_mb, (u32)200);
+    KUNIT_EXPECT_EQ(test, ewma_metric_read(&avg.cpu), 500UL);
+    KUNIT_EXPECT_EQ(test, ewma_metric_read(&avg.io), 256UL);
+    KUNIT_EXPECT_EQ(test, ewma_metric_read(&avg.syscalls), 75UL);
+    KUNIT_EXPECT_EQ(test, risk_mem_growth_kb_min(avg.mem_trend), (u64)38400);
+    // CPU média e crescimento alto da memória
+    KUNIT_EXPECT_EQ(test, risk_averages_score(&avg, d.rss_mb), 3);
+
+    prev = cur;
+    cur.cpu_ns = 0;
+    risk_refresh(&d, &avg, &prev, &cur, 2 * RISK_WINDOW_NS);
+    KUNIT_EXPECT_EQ(test, d.cpu_ms, (u32)0);
+    KUNIT_EXPECT_EQ(test, d.io_kb, (u32)0);
+}
+
+static struct kunit_case process_risk_score_cases[] = {
+    KUNIT_CASE(risk_counter_delta_test),
+    KUNIT_CASE(risk_normalize_delta_test),
+    KUNIT_CASE(risk_sat_u32_test),
+    KUNIT_CASE(ewma_metric_test),
+    KUNIT_CASE(risk_mem_trend_test),
+    KUNIT_CASE(risk_points_test),
+    KUNIT_CASE(risk_score_test),
+    KUNIT_CASE(risk_level_test),
+    KUNIT_CASE(risk_spike_test),
+    KUNIT_CASE(risk_refresh_test),
+    {}
+};
+
+static struct kunit_suite process_risk_score_suite = {
+    .name = "process_risk_score",
+    .test_cases = process_risk_score_cases,
+};
+kunit_test_suite(process_risk_score_suite);
+
+MODULE_LICENSE("GPL");
+MODULE_DESCRIPTION("Testes KUnit da pontuação de risco do process_risk");
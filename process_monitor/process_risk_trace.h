@@ -0,0 +1,91 @@
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM process_risk
+
+#if !defined(_PROCESS_RISK_TRACE_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _PROCESS_RISK_TRACE_H
+
+#include <linux/tracepoint.h>
+
+// tracepoints próprios do monitor, para correlacionar o custo das varreduras com a carga
+// do sistema no perf/ftrace (ex: perf record -e 'process_risk:*')
+
+TRACE_EVENT(process_risk_scan_start,
+    TP_PROTO(u64 generation, unsigned long tracked, bool reconcile),
+    TP_ARGS(generation, tracked, reconcile),
+
+    TP_STRUCT__entry(
+        __field(u64, generation)
+        __field(unsigned long, tracked)
+        __field(bool, reconcile)
+    ),
+
+    TP_fast_assign(
+        __entry->generation = generation;
+        __entry->tracked = tracked;
+        __entry->reconcile = reconcile;
+    ),
+
+    TP_printk("generation=%llu tracked=%lu reconcile=%d",
+              __entry->generation, __entry->tracked, __entry->reconcile)
+);
+
+TRACE_EVENT(process_risk_scan_end,
+    TP_PROTO(u64 generation, u64 duration_ns, unsigned long seen, unsigned long refreshed,
+             unsigned long created, unsigned long retired),
+    TP_ARGS(generation, duration_ns, seen, refreshed, created, retired),
+
+    TP_STRUCT__entry(
+        __field(u64, generation)
+        __field(u64, duration_ns)
+        __field(unsigned long, seen)
+        __field(unsigned long, refreshed)
+        __field(unsigned long, created)
+        __field(unsigned long, retired)
+    ),
+
+    TP_fast_assign(
+        __entry->generation = generation;
+        __entry->duration_ns = duration_ns;
+        __entry->seen = seen;
+        __entry->refreshed = refreshed;
+        __entry->created = created;
+        __entry->retired = retired;
+    ),
+
+    TP_printk("generation=%llu duration_ns=%llu seen=%lu refreshed=%lu created=%lu retired=%lu",
+              __entry->generation, __entry->duration_ns, __entry->seen,
+              __entry->refreshed, __entry->created, __entry->retired)
+);
+
+TRACE_EVENT(process_risk_transition,
+    TP_PROTO(pid_t pid, const char *comm, u8 old_risk, u8 new_risk, u8 score),
+    TP_ARGS(pid, comm, old_risk, new_risk, score),
+
+    TP_STRUCT__entry(
+        __field(pid_t, pid)
+        __array(char, comm, TASK_COMM_LEN)
+        __field(u8, old_risk)
+        __field(u8, new_risk)
+        __field(u8, score)
+    ),
+
+    TP_fast_assign(
+        __entry->pid = pid;
+        memcpy(__entry->comm, comm, TASK_COMM_LEN);
+        __entry->old_risk = old_risk;
+        __entry->new_risk = new_risk;
+        __entry->score = score;
+    ),
+
+    TP_printk("pid=%d comm=%s risk=%u->%u score=%u",
+              __entry->pid, __entry->comm, __entry->old_risk,
+              __entry->new_risk, __entry->score)
+);
+
+#endif
+
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE process_risk_trace
+#include <trace/define_trace.h>
@@ -0,0 +1,108 @@
+#ifndef PROCESS_RISK_UAPI_H
+#define PROCESS_RISK_UAPI_H
+
+#include <linux/types.h>
+
+// layout binário de /proc/process_risk/snapshot, compartilhado entre o módulo e os
+// consumidores no espaço do usuário. o arquivo é mapeado somente leitura com mmap: um
+// cabeçalho seguido de um vetor de registros de tamanho fixo.
+
+#define PROCESS_RISK_SNAPSHOT_MAGIC   0x50525353  // "PRSS"
+#define PROCESS_RISK_SNAPSHOT_VERSION 1
+
+// flags de struct process_risk_record
+#define PROCESS_RISK_REC_SYSCALLS_EXACT 0x1  // syscalls_delta veio do contador real
+
+// o campo seq funciona como um seqlock: fica ímpar enquanto o monitor reescreve os
+// registros. o leitor copia o que precisa entre duas leituras de seq e repete a cópia se
+// os valores diferirem ou forem ímpares. o monitor nunca espera pelos leitores.
+struct process_risk_snapshot_header {
+    __u32 magic;
+    __u32 version;
+    __u32 seq;
+    __u32 header_size;      // deslocamento do primeiro registro
+    __u32 record_size;
+    __u32 capacity;         // registros que cabem no mapeamento
+    __u32 count;            // registros válidos nesta geração
+    __u32 dropped;          // processos monitorados que não couberam
+    __u64 generation;       // número da varredura que produziu os registros
+    __u64 timestamp_ns;     // CLOCK_MONOTONIC do fim da varredura
+    __u32 interval_ms;
+    __u32 reserved[3];
+};
+
+struct process_risk_record {
+    __u64 start_time_ns;    // distingue PIDs reutilizados
+    __s32 pid;
+    __u32 cpu_delta_ms;
+    __u32 syscalls_delta;
+    __u32 io_delta_kb;
+    __u32 mem_rss_mb;
+    __u32 nr_threads;
+    __u8  score;
+    __u8  risk;             // 0 = baixo, 1 = médio, 2 = alto
+    __u16 flags;
+    char  comm[16];
+    __u32 reserved;
+};
+
+// evento lido de /proc/process_risk/events sempre que o nível de risco de um processo
+// monitorado muda. cada leitor tem seu próprio anel; eventos que não couberam no anel são
+// somados em dropped do próximo evento entregue a esse leitor.
+struct process_risk_event {
+    __u64 timestamp_ns;     // CLOCK_MONOTONIC da avaliação
+    __u64 start_time_ns;
+    __s32 pid;
+    __u8  old_risk;
+    __u8  new_risk;
+    __u8  score;
+    __u8  flags;            // PROCESS_RISK_REC_*
+    __u32 cpu_delta_ms;
+    __u32 syscalls_delta;
+    __u32 io_delta_kb;
+    __u32 mem_rss_mb;
+    __u32 nr_threads;
+    __u32 dropped;          // eventos perdidos por este leitor antes deste
+    char  comm[16];
+};
+
+// família generic netlink: PROCESS_RISK_CMD_GET consulta um PID (doit) ou despeja a
+// tabela em mensagens multipart (dump), filtrada por PROCESS_RISK_A_UID,
+// PROCESS_RISK_A_CGROUP e PROCESS_RISK_A_MIN_SCORE. o grupo multicast "alerts" recebe um
+// PROCESS_RISK_CMD_ALERT a cada mudança de nível.
+#define PROCESS_RISK_GENL_NAME          "process_risk"
+#define PROCESS_RISK_GENL_VERSION       1
+#define PROCESS_RISK_GENL_MCGRP_ALERTS  "alerts"
+
+enum {
+    PROCESS_RISK_CMD_UNSPEC,
+    PROCESS_RISK_CMD_GET,
+    PROCESS_RISK_CMD_ALERT,
+    __PROCESS_RISK_CMD_MAX,
+};
+#define PROCESS_RISK_CMD_MAX (__PROCESS_RISK_CMD_MAX - 1)
+
+enum {
+    PROCESS_RISK_A_UNSPEC,
+    PROCESS_RISK_A_PAD,
+    PROCESS_RISK_A_PID,             // u32
+    PROCESS_RISK_A_COMM,            // string
+    PROCESS_RISK_A_START_TIME,      // u64, ns
+    PROCESS_RISK_A_CPU_MS,          // u32
+    PROCESS_RISK_A_SYSCALLS,        // u32
+    PROCESS_RISK_A_IO_KB,           // u32
+    PROCESS_RISK_A_MEM_MB,          // u32
+    PROCESS_RISK_A_THREADS,         // u32
+    PROCESS_RISK_A_SCORE,           // u8
+    PROCESS_RISK_A_RISK,            // u8
+    PROCESS_RISK_A_OLD_RISK,        // u8, só em alertas
+    PROCESS_RISK_A_FLAGS,           // u32, PROCESS_RISK_REC_*
+    PROCESS_RISK_A_UID,             // u32
+    PROCESS_RISK_A_CGROUP,          // u64, id do cgroup v2
+    PROCESS_RISK_A_TIMESTAMP,       // u64, CLOCK_MONOTONIC, só em alertas
+    PROCESS_RISK_A_MIN_SCORE,       // u8, filtro do dump
+    __PROCESS_RISK_A_MAX,
+};
+#define PROCESS_RISK_A_MAX (__PROCESS_RISK_A_MAX - 1)
+
+#endif
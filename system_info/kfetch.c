@@ -4,15 +4,298 @@
 #include <unistd.h>     
 #include <string.h>   
 #include <errno.h>      
+#include <limits.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/ioctl.h>
+
+#include "kfetch_uapi.h"
 
 #define DEVICE_PATH "/dev/kfetch"  // Caminho do dispositivo criado pelo módulo do kernel
+#define BENCH_SECONDS 2            // Duração padrão de cada rodada da medição
+
+// Estado de uma thread da medição de vazão
+struct bench_thread {
+    pthread_t tid;
+    double deadline;        // Instante (CLOCK_MONOTONIC) em que a thread para
+    unsigned long reads;    // Ciclos open/read/close completos
+    unsigned long errors;   // Falhas de open ou read (ex: EBUSY)
+};
+
+static double now_seconds(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Cada thread abre, lê a saída inteira e fecha o dispositivo repetidamente até o prazo
+static void *bench_reader(void *arg) {
+    struct bench_thread *t = arg;
+    char buf[4096];
+
+    while (now_seconds() < t->deadline) {
+        int fd = open(DEVICE_PATH, O_RDONLY);
+        if (fd < 0) {
+            t->errors++;
+            continue;
+        }
+        if (read(fd, buf, sizeof(buf)) < 0)
+            t->errors++;
+        else
+            t->reads++;
+        close(fd);
+    }
+    return NULL;
+}
+
+// Mede a vazão de leitores simultâneos com 1, 2, 4, ... até max_threads threads
+static int bench_throughput(int max_threads, int seconds) {
+    struct bench_thread *threads = calloc(max_threads, sizeof(*threads));
+    if (!threads) {
+        perror("Erro ao alocar as threads");
+        return 1;
+    }
+
+    printf("%8s %14s %10s\n", "threads", "leituras/s", "erros");
+    for (int n = 1; ; n *= 2) {
+        double start = now_seconds();
+        unsigned long reads = 0, errors = 0;
+
+        if (n > max_threads)
+            n = max_threads;  // A última rodada usa exatamente max_threads
+
+        for (int i = 0; i < n; i++) {
+            threads[i] = (struct bench_thread) { .deadline = start + seconds };
+            if (pthread_create(&threads[i].tid, NULL, bench_reader, &threads[i]) != 0) {
+                perror("Erro ao criar thread");
+                free(threads);
+                return 1;
+            }
+        }
+        for (int i = 0; i < n; i++) {
+            pthread_join(threads[i].tid, NULL);
+            reads += threads[i].reads;
+            errors += threads[i].errors;
+        }
+
+        printf("%8d %14.0f %10lu\n", n, reads / (now_seconds() - start), errors);
+        if (n >= max_threads)
+            break;
+    }
+
+    free(threads);
+    return 0;
+}
+
+// Copia a mensagem da página mapeada, repetindo enquanto o módulo estiver reescrevendo
+static size_t page_copy(const volatile struct kfetch_page *page, char *buf, size_t size) {
+    unsigned int seq;
+    size_t len;
+
+    do {
+        seq = __atomic_load_n(&page->seq, __ATOMIC_ACQUIRE);
+        len = page->len < size ? page->len : size - 1;
+        memcpy(buf, (const char *)page->msg, len);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while ((seq & 1) || seq != page->seq);
+
+    buf[len] = '\0';
+    return len;
+}
+
+// Compara os caminhos de leitura: open+read+close (mensagem atual), pread no mesmo
+// descritor (só a cópia) e a página mapeada com mmap (sem cópia pelo kernel)
+static int bench_paths(int seconds) {
+    const char *names[] = { "open+read+close", "pread", "mmap" };
+    char buf[4096];
+    const struct kfetch_page *page;
+    int fd;
+
+    fd = open(DEVICE_PATH, O_RDONLY);
+    if (fd < 0) {
+        perror("Erro ao abrir o dispositivo para leitura");
+        return 1;
+    }
+    page = mmap(NULL, KFETCH_PAGE_SIZE, PROT_READ, MAP_SHARED, fd, 0);
+    if (page == MAP_FAILED) {
+        perror("Erro ao mapear o dispositivo");
+        close(fd);
+        return 1;
+    }
+    if (page->magic != KFETCH_PAGE_MAGIC) {
+        fprintf(stderr, "Página mapeada com formato desconhecido\n");
+        munmap((void *)page, KFETCH_PAGE_SIZE);
+        close(fd);
+        return 1;
+    }
+
+    printf("%-16s %14s %12s\n", "caminho", "leituras/s", "ns/leitura");
+    for (int path = 0; path < 3; path++) {
+        double start = now_seconds(), deadline = start + seconds, elapsed;
+        unsigned long reads = 0;
+
+        while (now_seconds() < deadline) {
+            // Lotes de leituras entre as consultas ao relógio
+            for (int i = 0; i < 64; i++) {
+                ssize_t n = 0;
+
+                if (path == 0) {
+                    int rfd = open(DEVICE_PATH, O_RDONLY);
+                    if (rfd < 0) {
+                        perror("Erro ao abrir o dispositivo para leitura");
+                        break;
+                    }
+                    n = read(rfd, buf, sizeof(buf));
+                    close(rfd);
+                } else if (path == 1) {
+                    n = pread(fd, buf, sizeof(buf), 0);
+                } else {
+                    n = page_copy(page, buf, sizeof(buf));
+                }
+                if (n <= 0) {
+                    fprintf(stderr, "Leitura vazia no caminho %s\n", names[path]);
+                    break;
+                }
+                reads++;
+            }
+        }
+
+        elapsed = now_seconds() - start;
+        printf("%-16s %14.0f %12.0f\n", names[path], reads / elapsed,
+               reads ? elapsed * 1e9 / reads : 0.0);
+    }
+
+    munmap((void *)page, KFETCH_PAGE_SIZE);
+    close(fd);
+    return 0;
+}
+
+// Abre o dispositivo para leitura. Com mask >= 0 troca só a máscara deste descritor
+// (KFETCH_IOC_SET_MASK), sem mudar a máscara padrão usada pelos outros programas
+static int open_with_mask(int mask) {
+    __u32 fd_mask = mask;
+    int fd;
+
+    fd = open(DEVICE_PATH, O_RDONLY);
+    if (fd < 0) {
+        perror("Erro ao abrir o dispositivo para leitura");
+        return -1;
+    }
+    if (mask >= 0 && ioctl(fd, KFETCH_IOC_SET_MASK, &fd_mask) < 0) {
+        perror("Erro no ioctl KFETCH_IOC_SET_MASK");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Lê os valores brutos com KFETCH_IOC_INFO e os imprime sem arredondamento
+static int print_info(int mask) {
+    struct kfetch_info info;
+    int fd;
+
+    fd = open_with_mask(mask);
+    if (fd < 0)
+        return 1;
+    if (ioctl(fd, KFETCH_IOC_INFO, &info) < 0) {
+        perror("Erro no ioctl KFETCH_IOC_INFO");
+        close(fd);
+        return 1;
+    }
+    close(fd);
+
+    // Versões mais novas só acrescentam campos no fim; os conhecidos continuam válidos
+    if (info.version < KFETCH_INFO_VERSION || info.size < sizeof(info)) {
+        fprintf(stderr, "Versão %u da interface não suportada\n", info.version);
+        return 1;
+    }
+
+    printf("host: %s\n", info.nodename);
+    if (info.mask & KFETCH_RELEASE)
+        printf("kernel: %s\n", info.release);
+    if (info.mask & KFETCH_CPU_MODEL)
+        printf("cpu_model: %s\n", info.cpu_model);
+    if (info.mask & KFETCH_NUM_CPUS)
+        printf("cpus: %u/%u\n", info.cpus_online, info.cpus_possible);
+    if (info.mask & KFETCH_MEM)
+        printf("mem_free_bytes: %llu\nmem_total_bytes: %llu\n",
+               (unsigned long long)info.mem_free, (unsigned long long)info.mem_total);
+    if (info.mask & KFETCH_NUM_PROCS)
+        printf("tasks: %u\n", info.nr_tasks);
+    if (info.mask & KFETCH_UPTIME)
+        printf("uptime: %llu.%09llu s\n",
+               (unsigned long long)info.uptime_sec, (unsigned long long)info.uptime_nsec);
+    printf("load: %.2f %.2f %.2f\n",
+           info.loads[0] / (double)(1 << KFETCH_LOAD_SHIFT),
+           info.loads[1] / (double)(1 << KFETCH_LOAD_SHIFT),
+           info.loads[2] / (double)(1 << KFETCH_LOAD_SHIFT));
+    return 0;
+}
+
+// Converte um argumento decimal, recusando texto extra e valores fora de [min, max]
+static int parse_number(const char *arg, long min, long max, long *value) {
+    char *end;
+
+    errno = 0;
+    *value = strtol(arg, &end, 10);
+    if (errno || end == arg || *end || *value < min || *value > max)
+        return -1;
+    return 0;
+}
+
+static int usage(const char *prog) {
+    fprintf(stderr,
+            "Uso: %s                          lê as informações\n"
+            "     %s <máscara>                define a máscara padrão (0 a %d)\n"
+            "     %s -m <máscara>             lê com uma máscara só deste descritor\n"
+            "     %s -i [máscara]             valores brutos pelo ioctl\n"
+            "     %s -t <threads> [segundos]  vazão com leitores simultâneos\n"
+            "     %s -b [segundos]            compara os caminhos de leitura\n",
+            prog, prog, KFETCH_FULL_INFO, prog, prog, prog, prog);
+    return 1;
+}
 
 int main(int argc, char *argv[]) {
+    long mask = -1, threads, seconds = BENCH_SECONDS;
     int fd;
 
-    // Caso o programa seja chamado com 1 argumento (além do nome), escreve a máscara
-    if (argc == 2) {
-        int mask = atoi(argv[1]); // Converte a string do argumento para inteiro
+    // Opções começam com '-' e são tratadas antes da escrita da máscara, então uma opção
+    // sem valor nunca vira uma máscara escrita no dispositivo
+    if (argc >= 2 && argv[1][0] == '-') {
+        const char *opt = argv[1];
+
+        // Modo de medição: ./kfetch -t <threads> [segundos]
+        if (strcmp(opt, "-t") == 0) {
+            if (argc < 3 || argc > 4 || parse_number(argv[2], 1, INT_MAX, &threads) ||
+                (argc == 4 && parse_number(argv[3], 1, INT_MAX, &seconds)))
+                return usage(argv[0]);
+            return bench_throughput(threads, seconds);
+        }
+
+        // Modo de comparação dos caminhos de leitura: ./kfetch -b [segundos]
+        if (strcmp(opt, "-b") == 0) {
+            if (argc > 3 || (argc == 3 && parse_number(argv[2], 1, INT_MAX, &seconds)))
+                return usage(argv[0]);
+            return bench_paths(seconds);
+        }
+
+        // Valores brutos pelo ioctl: ./kfetch -i [máscara]
+        if (strcmp(opt, "-i") == 0) {
+            if (argc > 3 || (argc == 3 && parse_number(argv[2], 0, KFETCH_FULL_INFO, &mask)))
+                return usage(argv[0]);
+            return print_info(mask);
+        }
+
+        // Leitura com uma máscara só deste descritor: ./kfetch -m <máscara>
+        if (strcmp(opt, "-m") != 0 || argc != 3 ||
+            parse_number(argv[2], 0, KFETCH_FULL_INFO, &mask))
+            return usage(argv[0]);
+    } else if (argc == 2) {
+        // Um número sozinho define a máscara padrão, escrita em decimal no dispositivo
+        if (parse_number(argv[1], 0, KFETCH_FULL_INFO, &mask))
+            return usage(argv[0]);
 
         // Abre o dispositivo para escrita
         fd = open(DEVICE_PATH, O_WRONLY);
@@ -23,7 +306,7 @@ int main(int argc, char *argv[]) {
 
         // Prepara o buffer com a máscara a ser enviada
         char buf[16];
-        snprintf(buf, sizeof(buf), "%d", mask);
+        snprintf(buf, sizeof(buf), "%ld", mask);
 
         // Escreve a máscara no dispositivo
         ssize_t written = write(fd, buf, strlen(buf));
@@ -33,29 +316,29 @@ int main(int argc, char *argv[]) {
             return 1;
         }
 
-        printf("Máscara %d escrita com sucesso no dispositivo.\n", mask);
+        printf("Máscara %ld escrita com sucesso no dispositivo.\n", mask);
         close(fd); // Fecha o descritor de arquivo
-    } else {
-        // Se nenhum argumento for fornecido, apenas lê as informações
+        return 0;
+    } else if (argc > 2) {
+        return usage(argv[0]);
+    }
 
-        fd = open(DEVICE_PATH, O_RDONLY); // Abre o dispositivo para leitura
-        if (fd < 0) {
-            perror("Erro ao abrir o dispositivo para leitura");
-            return 1;
-        }
+    // Sem argumentos lê as informações da máscara padrão; com -m, da máscara pedida
+    fd = open_with_mask(mask); // Abre o dispositivo para leitura
+    if (fd < 0)
+        return 1;
 
-        char buf[2048]; // Buffer grande o suficiente para conter a saída completa
-        ssize_t bytesRead = read(fd, buf, sizeof(buf) - 1); // Lê a saída do dispositivo
-        if (bytesRead < 0) {
-            perror("Erro ao ler do dispositivo");
-            close(fd);
-            return 1;
-        }
-
-        buf[bytesRead] = '\0'; // Garante terminação nula da string lida
-        printf("%s\n", buf);    // Imprime a saída formatada do dispositivo
-        close(fd);              // Fecha o descritor de arquivo
+    char buf[2048]; // Buffer grande o suficiente para conter a saída completa
+    ssize_t bytesRead = read(fd, buf, sizeof(buf) - 1); // Lê a saída do dispositivo
+    if (bytesRead < 0) {
+        perror("Erro ao ler do dispositivo");
+        close(fd);
+        return 1;
     }
 
+    buf[bytesRead] = '\0'; // Garante terminação nula da string lida
+    printf("%s\n", buf);    // Imprime a saída formatada do dispositivo
+    close(fd);              // Fecha o descritor de arquivo
+
     return 0; // Retorno bem-sucedido
 }
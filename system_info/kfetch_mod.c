@@ -26,26 +26,23 @@
 #include <linux/sched/stat.h> 
 #include <linux/kernel_stat.h>
 #include <linux/sched.h>
+#include <linux/sched/loadavg.h>
 #include <linux/mutex.h>
+#include <linux/rcupdate.h>
+#include <linux/workqueue.h>
+#include <linux/jiffies.h>
+#include <linux/moduleparam.h>
+#include <linux/pid_namespace.h>
+#include <linux/vmalloc.h>
+
+#include "kfetch_uapi.h"
 
 MODULE_LICENSE("GPL");
 MODULE_AUTHOR("Alexandre A., Augusto M., Felipe K., Hugo T., Matheus A., Vinicius B., Vinicius G.");
 MODULE_DESCRIPTION("Módulo que cria um dispositivo de caractere que mostra as informações do sistema, como nome do host,versão do kernel, modelo da CPU, núcleosonline e total da CPU, memória livre e total, número do processos e uptime");
     
 
-static DEFINE_MUTEX(info_mutex);
-
-
-//Definindo máscara 
-#define KFETCH_NUM_INFO 6
-#define KFETCH_RELEASE   (1 << 0)
-#define KFETCH_NUM_CPUS  (1 << 1)
-#define KFETCH_CPU_MODEL (1 << 2)
-#define KFETCH_MEM       (1 << 3)
-#define KFETCH_UPTIME    (1 << 4)
-#define KFETCH_NUM_PROCS (1 << 5)
-
-#define KFETCH_FULL_INFO ((1 << KFETCH_NUM_INFO) - 1);
+//Máscara de informações (KFETCH_*) definida em kfetch_uapi.h
 
  
 //Operaçoes do dispositivo
@@ -54,6 +51,10 @@ static int device_release(struct inode *, struct file *);
 static ssize_t device_read(struct file *, char __user *, size_t, loff_t *); 
 static ssize_t device_write(struct file *, const char __user *, size_t, 
                             loff_t *); 
+static loff_t device_llseek(struct file *, loff_t, int);
+static int device_mmap(struct file *, struct vm_area_struct *);
+static long device_ioctl(struct file *, unsigned int, unsigned long);
+static void kfetch_refresh_work(struct work_struct *work);
  
 //Nome dos dispositivos                          
 #define DEVICE_NAME "kfetch" 
@@ -61,21 +62,53 @@ static ssize_t device_write(struct file *, const char __user *, size_t,
 #define BUF_LEN 2000 
 
 
+//Mascara padrao dos novos arquivos abertos, alterada pela escrita em decimal. Cada arquivo
+//aberto copia o valor no open e tem a sua propria mascara a partir dai
 static int info_mask = KFETCH_FULL_INFO; 
 
 //Numero major do dispositivo
 static int major; 
  
-enum { 
-    CDEV_NOT_USED, 
-    CDEV_EXCLUSIVE_OPEN, 
-}; 
+//Mensagem e mascara de cada arquivo aberto, guardadas em file->private_data. Cada open tem
+//a sua, entao qualquer numero de leitores pode usar o dispositivo ao mesmo tempo. A mensagem
+//so e gerada na primeira leitura depois do open ou de uma troca de mascara (filled). O lock
+//so protege contra uma troca de mascara concorrente com a leitura no mesmo arquivo
+struct kfetch_buffer {
+    struct mutex lock;
+    int mask;
+    bool filled;
+    size_t len;
+    char msg[BUF_LEN + 1];
+};
  
-// Previne o acesso de múltiplos dispositivos no device ao mesmo tempo
-static atomic_t already_open = ATOMIC_INIT(CDEV_NOT_USED); 
- 
-//Mensagem quando for solicitada a leitura
-static char msg[BUF_LEN + 1]; 
+//Mensagem pronta mais recente de cada mascara, compartilhada por todos os opens. É imutavel
+//depois de publicada (RCU): uma nova versao substitui a anterior, entao o open so copia a
+//mensagem. used_masks marca as mascaras lidas desde a ultima atualizacao em segundo plano
+struct kfetch_snapshot {
+    struct rcu_head rcu;
+    unsigned long stamp;    //jiffies de quando foi gerada
+    size_t len;
+    char msg[BUF_LEN + 1];
+};
+
+static struct kfetch_snapshot __rcu *snapshots[KFETCH_FULL_INFO + 1];
+static DECLARE_BITMAP(used_masks, KFETCH_FULL_INFO + 1);
+static DEFINE_MUTEX(snapshot_mutex);
+static DECLARE_DELAYED_WORK(refresh_work, kfetch_refresh_work);
+
+//Pagina exposta por mmap com a mensagem mais recente da mascara padrao (layout em
+//kfetch_uapi.h). So e escrita sob snapshot_mutex; mmap_users conta os mapeamentos que
+//mantem a atualizacao ativa
+static struct kfetch_page *page_buf;
+static atomic_t mmap_users = ATOMIC_INIT(0);
+
+//Periodo de atualizacao da pagina mapeada quando max_age_ms e 0
+#define KFETCH_MMAP_REFRESH_MS 500
+
+//Idade maxima da mensagem entregue no open; 0 gera uma mensagem nova a cada open
+static unsigned int max_age_ms = 1000;
+module_param(max_age_ms, uint, 0644);
+MODULE_PARM_DESC(max_age_ms, "Idade máxima em ms das informações entregues no open (padrão 1000, 0 = sempre atualizadas)");
  
 static struct class *cls; 
 
@@ -85,6 +118,10 @@ static struct file_operations kfetch_fops = {
     .write = device_write, 
     .open = device_open, 
     .release = device_release, 
+    .llseek = device_llseek, 
+    .mmap = device_mmap, 
+    .unlocked_ioctl = device_ioctl, 
+    .compat_ioctl = compat_ptr_ioctl, 
 }; 
  
 
@@ -94,10 +131,20 @@ Função chamada na inserção do módulo. Responsável por registrar o disposit
 */
 static int __init kfetch_init(void) 
 { 
+    //Pagina do mmap, alocada antes do dispositivo existir. Os programas mapeiam
+    //KFETCH_PAGE_SIZE bytes, que cabem em uma pagina de qualquer tamanho
+    BUILD_BUG_ON(sizeof(struct kfetch_page) + BUF_LEN + 1 > KFETCH_PAGE_SIZE);
+    BUILD_BUG_ON(KFETCH_PAGE_SIZE > PAGE_SIZE);
+    page_buf = vmalloc_user(PAGE_SIZE);
+    if (!page_buf)
+        return -ENOMEM;
+    page_buf->magic = KFETCH_PAGE_MAGIC;
+
     //Criando dispositivo
     major = register_chrdev(0, DEVICE_NAME, &kfetch_fops); 
     if (major < 0) { 
         pr_alert("Registering char device failed with %d\n", major); 
+        vfree(page_buf);
         return major; 
     } 
  
@@ -126,88 +173,117 @@ static void __exit kfetch_exit(void)
  
     
     unregister_chrdev(major, DEVICE_NAME); 
+
+    //Sem o dispositivo nao ha mais leitores: para a atualizacao e libera as mensagens
+    cancel_delayed_work_sync(&refresh_work);
+    for (int m = 0; m <= KFETCH_FULL_INFO; m++)
+        kfree(rcu_dereference_protected(snapshots[m], 1));
+    vfree(page_buf);
 } 
  
 
 /*
-Executada ao abrir o dispositivo. Coleta dinamicamente as informações do sistema, de acordo com a máscara atual, e as armazena na variável msg. Também aplica um bloqueio com mutex para garantir consistência e evita acessos simultâneos com atomic_t already_open.
+Coleta os valores brutos das informacoes selecionadas pela mascara. O nome do host e as medias de carga sao sempre preenchidos. E a unica fonte dos dados, usada tanto pelo ioctl quanto pela mensagem em texto.
 */
-static int device_open(struct inode *inode, struct file *file) 
-{ 
-    //Verifica se arquivo já está sendo usado
-    if (atomic_cmpxchg(&already_open, CDEV_NOT_USED, CDEV_EXCLUSIVE_OPEN) != CDEV_NOT_USED) {
-        pr_alert("Device already in use\n");
-        return -EBUSY; 
-    }
+static void kfetch_gather(struct kfetch_info *info, int local_mask)
+{
+    memset(info, 0, sizeof(*info));
+    info->version = KFETCH_INFO_VERSION;
+    info->size = sizeof(*info);
+    info->mask = local_mask & KFETCH_FULL_INFO;
 
-    //Linha depois do nome do host
-    char *line;
+    strscpy(info->nodename, utsname()->nodename, sizeof(info->nodename));
 
-    int j = 0;
-    line = kmalloc(256, GFP_KERNEL);
- 
-    //Calculando o tamanho da linha
-    while(utsname()->nodename[j] != '\0'){
-        line[j] = '-';
-        j++;
-    }
-
-    
-    //Variaveis para as informacoes do dispositivo
-    char release[64] = "";
-    char cpu_model[64] = "";
-    char mem_info[64] = "";
-    char uptime_info[64] = "";
-    char procs_info[64] = "";
-    char cpus_info[64] = "";
+    //Medias de carga convertidas para o mesmo ponto fixo do sysinfo
+    info->loads[0] = (u64)avenrun[0] << (KFETCH_LOAD_SHIFT - FSHIFT);
+    info->loads[1] = (u64)avenrun[1] << (KFETCH_LOAD_SHIFT - FSHIFT);
+    info->loads[2] = (u64)avenrun[2] << (KFETCH_LOAD_SHIFT - FSHIFT);
 
-    int local_mask;
-    mutex_lock(&info_mutex);
-    local_mask = info_mask;
-    mutex_unlock(&info_mutex);
     //Informacao versao do kernel
     if (local_mask & KFETCH_RELEASE) {
-        snprintf(release, sizeof(release), "Kernel: %s", utsname()->release);
+        strscpy(info->release, utsname()->release, sizeof(info->release));
     }
 
     //Informacao modelo da cpu
     if (local_mask & KFETCH_CPU_MODEL) {
         struct cpuinfo_x86 *c = &cpu_data(0);
-        snprintf(cpu_model, sizeof(cpu_model), "CPU: %s", c->x86_model_id);
+        strscpy(info->cpu_model, c->x86_model_id, sizeof(info->cpu_model));
     }
     //Informacao memoria
     if (local_mask & KFETCH_MEM) {
         struct sysinfo i;
         si_meminfo(&i);
-        unsigned long totalram_mb = (i.totalram * i.mem_unit) >> 20;
-        unsigned long freeram_mb = (i.freeram * i.mem_unit) >> 20;
-        snprintf(mem_info, sizeof(mem_info), "Mem: %lu/%lu MB", freeram_mb, totalram_mb);
+        info->mem_total = (u64)i.totalram * i.mem_unit;
+        info->mem_free = (u64)i.freeram * i.mem_unit;
     }
 
     //Informacao uptime
     if (local_mask & KFETCH_UPTIME) {
         struct timespec64 uptime;
         ktime_get_boottime_ts64(&uptime);
-        snprintf(uptime_info, sizeof(uptime_info), "Uptime: %llu minutos", uptime.tv_sec / 60);
+        info->uptime_sec = uptime.tv_sec;
+        info->uptime_nsec = uptime.tv_nsec;
     }
 
-    //Informacao num de processos
+    //Informacao num de tarefas: contagem O(1) dos PIDs alocados no namespace inicial, um
+    //por tarefa, threads incluidas (mesmo criterio do campo procs do sysinfo), em vez de
+    //percorrer as tarefas. Por isso a linha se chama Tasks, e nao Procs
     if (local_mask & KFETCH_NUM_PROCS) {
-        struct task_struct *task;
-        unsigned int num_procs = 0;
-        for_each_process(task)
-            num_procs++;
-        snprintf(procs_info, sizeof(procs_info), "Procs: %u", num_procs);
+        info->nr_tasks = READ_ONCE(init_pid_ns.pid_allocated) & ~PIDNS_ADDING;
     }
 
     //Informacao num de cpus
     if (local_mask & KFETCH_NUM_CPUS) {
-        snprintf(cpus_info, sizeof(cpus_info), "CPUs: %u / %u", num_online_cpus(), num_possible_cpus());
+        info->cpus_online = num_online_cpus();
+        info->cpus_possible = num_possible_cpus();
     }
+}
+
+/*
+Monta a mensagem com as informacoes selecionadas pela mascara em buf e devolve o tamanho escrito.
+*/
+static size_t kfetch_render(char *buf, size_t size, int local_mask)
+{
+    struct kfetch_info info;
+    //Linha depois do nome do host
+    char line[__NEW_UTS_LEN + 1];
+    size_t j = 0;
+    int len;
+
+    kfetch_gather(&info, local_mask);
+
+    //Calculando o tamanho da linha
+    while (info.nodename[j] != '\0' && j < __NEW_UTS_LEN) {
+        line[j] = '-';
+        j++;
+    }
+    line[j] = '\0';
+
+    
+    //Variaveis para as informacoes do dispositivo
+    char release[80] = "";
+    char cpu_model[80] = "";
+    char mem_info[64] = "";
+    char uptime_info[64] = "";
+    char procs_info[64] = "";
+    char cpus_info[64] = "";
+
+    if (info.mask & KFETCH_RELEASE)
+        snprintf(release, sizeof(release), "Kernel: %s", info.release);
+    if (info.mask & KFETCH_CPU_MODEL)
+        snprintf(cpu_model, sizeof(cpu_model), "CPU: %s", info.cpu_model);
+    if (info.mask & KFETCH_MEM)
+        snprintf(mem_info, sizeof(mem_info), "Mem: %llu/%llu MB", info.mem_free >> 20, info.mem_total >> 20);
+    if (info.mask & KFETCH_UPTIME)
+        snprintf(uptime_info, sizeof(uptime_info), "Uptime: %llu minutos", info.uptime_sec / 60);
+    if (info.mask & KFETCH_NUM_PROCS)
+        snprintf(procs_info, sizeof(procs_info), "Tasks: %u", info.nr_tasks);
+    if (info.mask & KFETCH_NUM_CPUS)
+        snprintf(cpus_info, sizeof(cpus_info), "CPUs: %u / %u", info.cpus_online, info.cpus_possible);
  
    
     // Monta a mensagem com todas as informacoes e um belo javali
-    snprintf(msg, BUF_LEN,
+    len = snprintf(buf, size,
     "            ⣦⣼⣷⣦⣄⠀⢠⣶⠀⠀⠀⠀⢀⣠⠆⠀⠀      %s\n"
     "⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⣀⣴⣿⣿⣿⣿⣿⣿⠀⣿⣿⡆⢀⡀⠀⠛⠟⠀⠀⠀     %s\n"
     "⠀⠀⠀⠀⠀⠀⠀⣀⣴⣾⣿⣿⣿⣿⣿⣿⣿⣿⢀⣿⣿⣇⣸⣿⣿⣶⠀⠀⠀⠀     %s\n"
@@ -220,22 +296,188 @@ static int device_open(struct inode *inode, struct file *file)
     "⠀⠀⠀⢸⣿⣿⡄⠀⠙⠋⠉⠛⠋⠉⠀⠈⠻⣿⣇⠀⠀⣶⣶⡄⠀⠀⠀⠀⠀⠀\n"
     "⠀⠀⠀⢸⣿⡟⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠹⣿⠀⠀⢸⣿⡇⠀⠀⠀⠀⠀⠀\n"
     "⠀⠀⠀⠛⠛⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠛⠃⠀⠀⠛⠃⠀ \n",
-    utsname()->nodename,line,release,cpu_model,cpus_info,mem_info,procs_info,uptime_info);
- 
+    info.nodename,line,release,cpu_model,cpus_info,mem_info,procs_info,uptime_info);
+
+    //snprintf devolve o tamanho que a mensagem teria sem o limite do buffer
+    return min_t(size_t, len, size - 1);
+}
+
+/*
+Copia a mensagem compartilhada da mascara para buf se ela ainda esta dentro da idade maxima.
+*/
+static bool kfetch_snapshot_copy(struct kfetch_buffer *buf, int local_mask)
+{
+    unsigned int age_ms = READ_ONCE(max_age_ms);
+    struct kfetch_snapshot *snap;
+    bool hit = false;
+
+    if (!age_ms)
+        return false;
+
+    rcu_read_lock();
+    snap = rcu_dereference(snapshots[local_mask]);
+    if (snap && time_before(jiffies, snap->stamp + msecs_to_jiffies(age_ms))) {
+        memcpy(buf->msg, snap->msg, snap->len + 1);
+        buf->len = snap->len;
+        hit = true;
+    }
+    rcu_read_unlock();
+    return hit;
+}
+
+/*
+Publica uma nova mensagem compartilhada. Deve ser chamada com snapshot_mutex.
+*/
+static void kfetch_snapshot_publish(const char *msg, size_t len, int local_mask)
+{
+    struct kfetch_snapshot *snap, *old;
+
+    snap = kmalloc(sizeof(*snap), GFP_KERNEL);
+    if (!snap)
+        return;     //Sem memoria a proxima leitura apenas gera a mensagem de novo
+
+    snap->stamp = jiffies;
+    snap->len = len;
+    memcpy(snap->msg, msg, len + 1);
+
+    old = rcu_dereference_protected(snapshots[local_mask], lockdep_is_held(&snapshot_mutex));
+    rcu_assign_pointer(snapshots[local_mask], snap);
+    if (old)
+        kfree_rcu(old, rcu);
+}
+
+/*
+Copia a mensagem para a pagina do mmap se ela foi gerada com a mascara padrao. seq fica impar durante a escrita para que os leitores do mapeamento detectem copias inconsistentes e repitam a leitura. Deve ser chamada com snapshot_mutex.
+*/
+static void kfetch_page_publish(const char *msg, size_t len, int local_mask)
+{
+    if (local_mask != (READ_ONCE(info_mask) & KFETCH_FULL_INFO))
+        return;
+
+    WRITE_ONCE(page_buf->seq, page_buf->seq + 1);
+    smp_wmb();
 
-    kfree(line);
+    memcpy(page_buf->msg, msg, len + 1);
+    page_buf->len = len;
+    page_buf->mask = local_mask;
+    page_buf->stamp_ns = ktime_get_ns();
+
+    smp_wmb();
+    WRITE_ONCE(page_buf->seq, page_buf->seq + 1);
+}
+
+//Periodo da atualizacao em segundo plano: metade da idade maxima
+static unsigned long kfetch_refresh_delay(void)
+{
+    unsigned int age_ms = READ_ONCE(max_age_ms);
+
+    return msecs_to_jiffies(age_ms ? age_ms / 2 : KFETCH_MMAP_REFRESH_MS);
+}
+
+/*
+Atualizacao em segundo plano: gera de novo a mensagem compartilhada de cada mascara lida desde a ultima execucao (e a da mascara padrao, se a pagina estiver mapeada), para que os leitores frequentes encontrem sempre uma mensagem dentro da idade maxima. E agendada pelas leituras e se reagenda enquanto a pagina estiver mapeada, entao nao custa nada sem leitores.
+*/
+static void kfetch_refresh_work(struct work_struct *work)
+{
+    struct kfetch_buffer *buf;
+    bool mapped = atomic_read(&mmap_users);
+    int local_mask;
+
+    if (mapped)
+        set_bit(READ_ONCE(info_mask) & KFETCH_FULL_INFO, used_masks);
+
+    buf = kmalloc(sizeof(*buf), GFP_KERNEL);
+    if (buf) {
+        mutex_lock(&snapshot_mutex);
+        for (local_mask = 0; local_mask <= KFETCH_FULL_INFO; local_mask++) {
+            if (!test_and_clear_bit(local_mask, used_masks))
+                continue;
+            buf->len = kfetch_render(buf->msg, sizeof(buf->msg), local_mask);
+            kfetch_snapshot_publish(buf->msg, buf->len, local_mask);
+            kfetch_page_publish(buf->msg, buf->len, local_mask);
+        }
+        mutex_unlock(&snapshot_mutex);
+        kfree(buf);
+    }
+
+    if (mapped)
+        schedule_delayed_work(&refresh_work, kfetch_refresh_delay());
+}
+
+/*
+Preenche a mensagem de um arquivo aberto: copia a mensagem compartilhada quando ela serve, senao gera uma nova e a publica. O mutex faz com que varios opens simultaneos gerem a mensagem uma unica vez.
+*/
+static void kfetch_fill(struct kfetch_buffer *buf, int local_mask)
+{
+    unsigned int age_ms = READ_ONCE(max_age_ms);
+
+    if (!kfetch_snapshot_copy(buf, local_mask)) {
+        mutex_lock(&snapshot_mutex);
+        if (!kfetch_snapshot_copy(buf, local_mask)) {
+            buf->len = kfetch_render(buf->msg, sizeof(buf->msg), local_mask);
+            if (age_ms)
+                kfetch_snapshot_publish(buf->msg, buf->len, local_mask);
+            kfetch_page_publish(buf->msg, buf->len, local_mask);
+        }
+        mutex_unlock(&snapshot_mutex);
+    }
+
+    //Renova a mensagem na metade da idade maxima (nao faz nada se ja estiver agendado)
+    if (age_ms) {
+        set_bit(local_mask, used_masks);
+        schedule_delayed_work(&refresh_work, kfetch_refresh_delay());
+    }
+}
+
+/*
+Gera a mensagem de um arquivo aberto com a sua mascara atual, se ainda nao foi gerada. So as informacoes pedidas pela mascara sao coletadas. Deve ser chamada com buf->lock.
+*/
+static void kfetch_buffer_ready(struct kfetch_buffer *buf)
+{
+    if (!buf->filled) {
+        kfetch_fill(buf, buf->mask);
+        buf->filled = true;
+    }
+}
+
+/*
+Troca a mascara de um arquivo aberto. A mensagem e gerada de novo so na proxima leitura.
+*/
+static void kfetch_set_mask(struct kfetch_buffer *buf, int local_mask)
+{
+    mutex_lock(&buf->lock);
+    buf->mask = local_mask;
+    buf->filled = false;
+    mutex_unlock(&buf->lock);
+}
+
+/*
+Executada ao abrir o dispositivo. O arquivo aberto recebe a máscara padrão e um buffer próprio (file->private_data). Nada é coletado aqui: a mensagem é preenchida na primeira leitura, já com a máscara que o programa tiver escolhido com KFETCH_IOC_SET_MASK.
+*/
+static int device_open(struct inode *inode, struct file *file) 
+{ 
+    struct kfetch_buffer *buf;
+
+    buf = kmalloc(sizeof(*buf), GFP_KERNEL);
+    if (!buf)
+        return -ENOMEM;
+
+    mutex_init(&buf->lock);
+    buf->mask = READ_ONCE(info_mask) & KFETCH_FULL_INFO;
+    buf->filled = false;
+    file->private_data = buf;
 
     try_module_get(THIS_MODULE); 
     return 0; 
 } 
  
 /* 
-Executada quando o dispositivo é fechado. Libera o controle exclusivo do dispositivo e decrementa o contador de uso do módulo.
+Executada quando o dispositivo é fechado. Libera o buffer deste arquivo aberto e decrementa o contador de uso do módulo.
 */
 static int device_release(struct inode *inode, struct file *file) 
 { 
-    //Libera o dispositvo pro proximo usar
-    atomic_set(&already_open, CDEV_NOT_USED); 
+    //Libera a mensagem deste arquivo aberto
+    kfree(file->private_data); 
  
     //Decrementando o contador de uso
     module_put(THIS_MODULE); 
@@ -245,41 +487,125 @@ static int device_release(struct inode *inode, struct file *file)
  
 
 /*
-Executada ao ler o dispositivo. Copia o conteúdo da variável msg (preenchida em device_open) para o espaço do usuário usando put_user.
+Executada ao ler o dispositivo. Copia a mensagem deste arquivo aberto (preenchida na primeira leitura) para o espaço do usuário a partir de *offset, em uma única cópia. Normalmente é só uma cópia da mensagem compartilhada da mesma máscara; ela só é gerada de novo quando passa da idade máxima (max_age_ms). Funciona com read, pread e lseek; no fim da mensagem devolve 0.
 */
 static ssize_t device_read(struct file *filp, 
                            char __user *buffer, 
                            size_t length,  
                            loff_t *offset) 
 { 
+    struct kfetch_buffer *buf = filp->private_data;
+    ssize_t ret;
 
-    int bytes_read = 0; 
-    const char *msg_ptr = msg; 
- 
-    //Se estiver no fim da mensagem
-    if (!*(msg_ptr + *offset)) { 
-        *offset = 0; 
-        return 0; 
-    } 
- 
-    msg_ptr += *offset; 
- 
-    //Colocando mensagem no buffer
-    while (length && *msg_ptr) { 
-        put_user(*(msg_ptr++), buffer++); 
-        length--; 
-        bytes_read++; 
-    } 
- 
-    *offset += bytes_read; 
- 
-    
-    return bytes_read; 
+    mutex_lock(&buf->lock);
+    kfetch_buffer_ready(buf);
+    ret = simple_read_from_buffer(buffer, length, offset, buf->msg, buf->len);
+    mutex_unlock(&buf->lock);
+    return ret;
 } 
+
+/*
+Reposiciona o offset dentro da mensagem deste arquivo aberto (SEEK_END é relativo ao tamanho da mensagem).
+*/
+static loff_t device_llseek(struct file *filp, loff_t offset, int whence)
+{
+    struct kfetch_buffer *buf = filp->private_data;
+    loff_t ret;
+
+    mutex_lock(&buf->lock);
+    kfetch_buffer_ready(buf);
+    ret = fixed_size_llseek(filp, offset, whence, buf->len);
+    mutex_unlock(&buf->lock);
+    return ret;
+}
+
+static void kfetch_vm_open(struct vm_area_struct *vma)
+{
+    atomic_inc(&mmap_users);
+}
+
+static void kfetch_vm_close(struct vm_area_struct *vma)
+{
+    atomic_dec(&mmap_users);
+}
+
+static const struct vm_operations_struct kfetch_vm_ops = {
+    .open = kfetch_vm_open,
+    .close = kfetch_vm_close,
+};
+
+/*
+Mapeia a pagina com a mensagem mais recente da mascara padrao, somente leitura. A pagina e compartilhada por todos os mapeamentos, entao nao segue a mascara do arquivo aberto. Enquanto houver mapeamentos a mensagem e renovada em segundo plano, entao um leitor de alta frequencia le as informacoes sem nenhuma copia pelo kernel.
+*/
+static int device_mmap(struct file *filp, struct vm_area_struct *vma)
+{
+    struct kfetch_buffer *tmp;
+    int ret;
+
+    if (vma->vm_flags & VM_WRITE)
+        return -EPERM;
+    if (vma->vm_pgoff || vma->vm_end - vma->vm_start > PAGE_SIZE)
+        return -EINVAL;
+
+    //Impede que um mprotect posterior torne o mapeamento gravavel
+    #if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 3, 0)
+        vm_flags_clear(vma, VM_MAYWRITE);
+    #else
+        vma->vm_flags &= ~VM_MAYWRITE;
+    #endif
+
+    //Como nenhum open gera mensagem, garante que a pagina tenha uma dentro da idade maxima
+    //(kfetch_fill publica a pagina sempre que gera a mensagem da mascara padrao)
+    tmp = kmalloc(sizeof(*tmp), GFP_KERNEL);
+    if (!tmp)
+        return -ENOMEM;
+    kfetch_fill(tmp, READ_ONCE(info_mask) & KFETCH_FULL_INFO);
+    kfree(tmp);
+
+    ret = remap_vmalloc_range(vma, page_buf, 0);
+    if (ret)
+        return ret;
+
+    vma->vm_ops = &kfetch_vm_ops;
+    kfetch_vm_open(vma);
+    schedule_delayed_work(&refresh_work, kfetch_refresh_delay());
+    return 0;
+}
+ 
+/*
+Executada nas chamadas ioctl. KFETCH_IOC_INFO devolve as informacoes da mascara deste arquivo aberto como valores brutos em struct kfetch_info (kfetch_uapi.h), sem texto para interpretar. KFETCH_IOC_SET_MASK e KFETCH_IOC_GET_MASK trocam e consultam a mascara deste arquivo aberto, sem afetar os demais.
+*/
+static long device_ioctl(struct file *filp, unsigned int cmd, unsigned long arg)
+{
+    struct kfetch_buffer *buf = filp->private_data;
+    u32 __user *umask = (u32 __user *)arg;
+    struct kfetch_info info;
+    u32 mask_info;
+
+    switch (cmd) {
+    case KFETCH_IOC_INFO:
+        kfetch_gather(&info, READ_ONCE(buf->mask));
+        if (copy_to_user((void __user *)arg, &info, sizeof(info)))
+            return -EFAULT;
+        return 0;
+
+    case KFETCH_IOC_SET_MASK:
+        if (get_user(mask_info, umask))
+            return -EFAULT;
+        if (mask_info & ~KFETCH_FULL_INFO)
+            return -EINVAL;
+        kfetch_set_mask(buf, mask_info);
+        return 0;
+
+    case KFETCH_IOC_GET_MASK:
+        return put_user(READ_ONCE(buf->mask), umask);
+    }
+    return -ENOTTY;
+}
  
 /*
 device_write: Executada ao escrever no dispositivo. Lê uma string do usuário contendo um número inteiro (representando a nova máscara de bits),
-converte-a e atualiza a variável info_mask, que define quais informações serão exibidas nas próximas leituras. Toda a operação é protegida por mutex para garantir exclusividade durante a atualização.
+converte-a e aplica a máscara a este arquivo aberto. Por compatibilidade também atualiza info_mask, a máscara padrão dos próximos opens; para mudar só o próprio arquivo aberto use KFETCH_IOC_SET_MASK.
 */
 static ssize_t device_write(struct file *filp, const char __user *buff, 
                             size_t len, loff_t *off) 
@@ -302,11 +628,10 @@ static ssize_t device_write(struct file *filp, const char __user *buff,
         pr_alert("Error, couldn't covert to int\n");
         return -EINVAL;
     }
-    //Atualizando mascara com a nova informacao
-    mutex_lock(&info_mutex);
-    info_mask = mask_info;
-    mutex_unlock(&info_mutex);
-    pr_info("Mask updated: %d\n", info_mask);
+    //Atualizando mascara padrao e a deste arquivo aberto com a nova informacao
+    WRITE_ONCE(info_mask, mask_info);
+    kfetch_set_mask(filp->private_data, mask_info & KFETCH_FULL_INFO);
+    pr_info("Mask updated: %d\n", mask_info);
     return len;
 } 
  
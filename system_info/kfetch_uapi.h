@@ -0,0 +1,71 @@
+#ifndef KFETCH_UAPI_H
+#define KFETCH_UAPI_H
+
+#include <linux/types.h>
+#include <linux/ioctl.h>
+
+// Interface binária de /dev/kfetch, compartilhada entre o módulo e os programas do espaço
+// do usuário.
+
+// Máscara de informações: escolhe as linhas da saída em texto e os campos preenchidos
+// em struct kfetch_info
+#define KFETCH_NUM_INFO 6
+#define KFETCH_RELEASE   (1 << 0)  // Versão do kernel
+#define KFETCH_NUM_CPUS  (1 << 1)  // Número de CPUs
+#define KFETCH_CPU_MODEL (1 << 2)  // Modelo da CPU
+#define KFETCH_MEM       (1 << 3)  // Informações de memória
+#define KFETCH_UPTIME    (1 << 4)  // Tempo de atividade
+#define KFETCH_NUM_PROCS (1 << 5)  // Número de tarefas (threads incluídas)
+
+#define KFETCH_FULL_INFO ((1 << KFETCH_NUM_INFO) - 1)
+
+// Valores brutos devolvidos por KFETCH_IOC_INFO, sem arredondamento nem texto. O layout é
+// o mesmo em 32 e 64 bits. Campos novos só são acrescentados no fim, com um novo
+// KFETCH_INFO_VERSION; o programa confere version e size antes de usar os campos.
+#define KFETCH_INFO_VERSION 1
+#define KFETCH_LOAD_SHIFT   16   // loads[] em ponto fixo, como em sysinfo(2)
+
+struct kfetch_info {
+    __u32 version;          // KFETCH_INFO_VERSION do módulo
+    __u32 size;             // sizeof(struct kfetch_info) do módulo
+    __u32 mask;             // Campos KFETCH_* preenchidos nesta chamada
+    __u32 cpus_online;      // KFETCH_NUM_CPUS
+    __u32 cpus_possible;    // KFETCH_NUM_CPUS
+    __u32 nr_tasks;         // KFETCH_NUM_PROCS, tarefas (threads incluídas), não processos
+    __u64 mem_total;        // KFETCH_MEM, bytes
+    __u64 mem_free;         // KFETCH_MEM, bytes
+    __u64 uptime_sec;       // KFETCH_UPTIME, CLOCK_BOOTTIME
+    __u64 uptime_nsec;      // KFETCH_UPTIME
+    __u64 loads[3];         // Médias de carga de 1, 5 e 15 minutos (sempre preenchidas)
+    char  nodename[65];     // Sempre preenchido
+    char  release[65];      // KFETCH_RELEASE
+    char  cpu_model[64];    // KFETCH_CPU_MODEL
+    __u8  reserved[6];
+};
+
+// A máscara vale por descritor aberto: começa com a máscara padrão do dispositivo e pode
+// ser trocada com KFETCH_IOC_SET_MASK sem afetar os outros descritores. Escrever a máscara
+// em decimal com write continua funcionando e também muda a máscara padrão.
+#define KFETCH_IOC_MAGIC    'k'
+#define KFETCH_IOC_INFO     _IOR(KFETCH_IOC_MAGIC, 1, struct kfetch_info)
+#define KFETCH_IOC_SET_MASK _IOW(KFETCH_IOC_MAGIC, 2, __u32)
+#define KFETCH_IOC_GET_MASK _IOR(KFETCH_IOC_MAGIC, 3, __u32)
+
+// Página exposta por mmap (somente leitura): um cabeçalho seguido da mesma mensagem
+// entregue pelo read, terminada em '\0'. O módulo reescreve a página sempre que gera uma
+// mensagem nova, sem esperar pelos leitores; seq fica ímpar durante a escrita, então o
+// leitor copia o que precisa entre duas leituras de seq e repete se elas diferirem ou
+// forem ímpares.
+#define KFETCH_PAGE_MAGIC 0x4b464348  // "KFCH"
+#define KFETCH_PAGE_SIZE  4096        // Tamanho a mapear
+
+struct kfetch_page {
+    __u32 magic;
+    __u32 seq;
+    __u32 mask;         // Máscara usada para gerar a mensagem
+    __u32 len;          // Bytes de msg, sem o '\0'
+    __u64 stamp_ns;     // CLOCK_MONOTONIC de quando a mensagem foi gerada
+    char  msg[];
+};
+
+#endif